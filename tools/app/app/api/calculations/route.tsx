@@ -0,0 +1,44 @@
+import { NextRequest, NextResponse } from 'next/server'
+import { Calculate } from '@cyberismocom/data-handler/calculate'
+
+export const dynamic = 'force-dynamic'
+
+/**
+ * @swagger
+ * /api/calculations:
+ *   get:
+ *     summary: Returns status of calculation jobs in the defined project.
+ *     description: Calculations are run in the background after cards change. List includes queued, running and recently finished jobs.
+ *     parameters:
+ *       - name: id
+ *         in: query
+ *         required: false
+ *         description: Id of a job (number). If included, only status of that job is returned.
+ *     responses:
+ *       200:
+ *         description: Array of job statuses, or status of the requested job. Job state is one of queued, running, done, failed, cancelled or timeout.
+ *       400:
+ *         description: Invalid job id, or job not found.
+ *       500:
+ *         description: project_path not set.
+ */
+export async function GET(request: NextRequest) {
+  const projectPath = process.env.npm_config_project_path
+  if (!projectPath) {
+    return new NextResponse('project_path not set', { status: 500 })
+  }
+
+  const calculateCommand = new Calculate()
+  const id = request.nextUrl.searchParams.get('id')
+  if (id == null) {
+    return NextResponse.json(calculateCommand.jobs(projectPath))
+  }
+
+  const job = calculateCommand.job(projectPath, Number(id))
+  if (!job) {
+    return new NextResponse(`Calculation job '${id}' not found`, {
+      status: 400,
+    })
+  }
+  return NextResponse.json(job)
+}
@@ -1,12 +1,13 @@
 import { Calculate } from '@cyberismocom/data-handler/calculate'
+import { ProjectSession } from '@cyberismocom/data-handler/containers/project-session'
 import { Create } from '@cyberismocom/data-handler/create'
 import { Edit } from '@cyberismocom/data-handler/edit'
 import { Remove } from '@cyberismocom/data-handler/remove'
-import { Show } from '@cyberismocom/data-handler/show'
 import { Transition } from '@cyberismocom/data-handler/transition'
 
 import { NextRequest, NextResponse } from 'next/server'
 import {
+  card,
   fetchCardDetails,
   metadataContent,
 } from '@cyberismocom/data-handler/interfaces/project-interfaces'
@@ -18,7 +19,7 @@ export const dynamic = 'force-dynamic'
  * /api/cards/{key}:
  *   get:
  *     summary: Returns the full content of a specific card.
- *     description: The key parameter is the unique identifier ("cardKey") of the card. The response includes the metadata and the content of the card.
+ *     description: The key parameter is the unique identifier ("cardKey") of the card. The response includes the metadata, the content and the calculated fields of the card. Calculated fields come from the calculation cache. If they are not in the cache, the card is returned without them, and "calculationJob" is the id of the job that calculates them; poll the job from /api/calculations and fetch the card again once it has finished.
  *     parameters:
  *       - name: key
  *         in: path
@@ -28,6 +29,10 @@ export const dynamic = 'force-dynamic'
  *         in: query
  *         required: false
  *         description: Content type of the card. Must be adoc or html. Defaults to adoc if not included.
+ *       - name: profile
+ *         in: query
+ *         required: false
+ *         description: If true, the card is calculated with solver statistics, which are returned in the "profile" field. Statistics are given for the whole logic program and for each module.
  *     responses:
  *       200:
  *         description: Object containing card details. See definitions.ts/CardDetails for the structure.
@@ -96,8 +101,9 @@ export async function GET(request: NextRequest) {
 
   // contentType defaults to adoc if not set
   const contentType = request.nextUrl.searchParams.get('contentType') ?? 'adoc'
+  const profile = request.nextUrl.searchParams.get('profile') === 'true'
 
-  return await getCardDetails(projectPath, key, contentType)
+  return await getCardDetails(projectPath, key, contentType, profile)
 }
 
 export async function PUT(request: NextRequest) {
@@ -156,6 +162,8 @@ export async function PUT(request: NextRequest) {
 
   // TODO add other update options here
 
+  ProjectSession.getInstance(projectPath).cardChanged(key)
+
   // contentType defaults to adoc if not set
   const contentType = request.nextUrl.searchParams.get('contentType') ?? 'adoc'
 
@@ -184,7 +192,8 @@ export async function PUT(request: NextRequest) {
 async function getCardDetails(
   projectPath: string,
   key: string,
-  contentType: string
+  contentType: string,
+  profile: boolean = false
 ): Promise<NextResponse> {
   if (contentType !== 'adoc' && contentType !== 'html') {
     return new NextResponse('contentType must be adoc or html', { status: 400 })
@@ -192,6 +201,7 @@ async function getCardDetails(
 
   const fetchCardDetails: fetchCardDetails = {
     attachments: true,
+    calculations: true,
     children: false,
     content: true,
     contentType: contentType,
@@ -199,14 +209,13 @@ async function getCardDetails(
     parent: false,
   }
 
-  const showCommand = new Show()
   try {
-    const cardDetailsResponse = await showCommand.showCardDetails(
-      projectPath,
-      fetchCardDetails,
-      key
-    )
-    if (cardDetailsResponse) {
+    const cardDetailsResponse = await ProjectSession.getInstance(
+      projectPath
+    ).cardDetails(key, fetchCardDetails)
+    if (cardDetailsResponse && profile) {
+      return await getProfiledCardDetails(projectPath, cardDetailsResponse)
+    } else if (cardDetailsResponse) {
       return NextResponse.json(cardDetailsResponse)
     } else {
       return new NextResponse(`Card not found from path ${projectPath}`, {
@@ -220,6 +229,19 @@ async function getCardDetails(
   }
 }
 
+async function getProfiledCardDetails(
+  projectPath: string,
+  cardDetails: card
+): Promise<NextResponse> {
+  try {
+    const profile = await new Calculate().profile(projectPath, cardDetails.key)
+    return NextResponse.json({ ...cardDetails, profile: profile })
+  } catch (error) {
+    const message = error instanceof Error ? error.message : String(error)
+    return new NextResponse(`Profiling failed: ${message}`, { status: 400 })
+  }
+}
+
 export async function DELETE(request: NextRequest) {
   const projectPath = process.env.npm_config_project_path
   if (!projectPath) {
@@ -236,6 +258,7 @@ export async function DELETE(request: NextRequest) {
 
   try {
     await removeCommand.remove(projectPath, 'card', key)
+    ProjectSession.getInstance(projectPath).cardChanged()
     return new NextResponse(null, { status: 204 })
   } catch (error) {
     if (error instanceof Error) {
@@ -267,9 +290,13 @@ export async function POST(request: NextRequest) {
   const createCommand = new Create(new Calculate())
 
   try {
-    return NextResponse.json(
-      await createCommand.createCard(projectPath, res.template, key)
+    const cards = await createCommand.createCard(
+      projectPath,
+      res.template,
+      key
     )
+    ProjectSession.getInstance(projectPath).cardChanged(key)
+    return NextResponse.json(cards)
   } catch (error) {
     if (error instanceof Error) {
       return new NextResponse(error.message, { status: 400 })
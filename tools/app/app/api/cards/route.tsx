@@ -1,4 +1,4 @@
-import { Show } from '@cyberismocom/data-handler/show'
+import { ProjectSession } from '@cyberismocom/data-handler/containers/project-session'
 import { project } from '@cyberismocom/data-handler/interfaces/project-interfaces'
 import { NextResponse } from 'next/server'
 
@@ -26,34 +26,32 @@ export async function GET() {
     })
   }
 
-  const showCommand = new Show()
+  const session = ProjectSession.getInstance(projectPath)
 
   let projectResponse: project
   try {
-    projectResponse = await showCommand.showProject(projectPath)
+    projectResponse = await session.show()
   } catch (error) {
     return new NextResponse(`No project found from path ${projectPath}`, {
       status: 500,
     })
   }
 
-  const workflowsResponse =
-    await showCommand.showWorkflowsWithDetails(projectPath)
+  const workflowsResponse = await session.workflows()
   if (!workflowsResponse) {
     return new NextResponse(`No workflows found from path ${projectPath}`, {
       status: 500,
     })
   }
 
-  const cardTypesResponse =
-    await showCommand.showCardTypesWithDetails(projectPath)
+  const cardTypesResponse = await session.cardTypes()
   if (!cardTypesResponse) {
     return new NextResponse(`No card types found from path ${projectPath}`, {
       status: 500,
     })
   }
 
-  const cardsResponse = await showCommand.showProjectCards(projectPath)
+  const cardsResponse = await session.cards()
   if (cardsResponse) {
     const response = {
       name: (projectResponse! as any).name,
@@ -1,5 +1,5 @@
 import { NextRequest, NextResponse } from 'next/server'
-import { Show } from '@cyberismocom/data-handler/show'
+import { ProjectSession } from '@cyberismocom/data-handler/containers/project-session'
 
 export const dynamic = 'force-dynamic'
 
@@ -29,8 +29,8 @@ export async function GET(request: NextRequest) {
     return new NextResponse('No search key', { status: 400 })
   }
 
-  const show = new Show()
-  const detailsResponse = await show.showCardTypeDetails(projectPath, key)
+  const session = ProjectSession.getInstance(projectPath)
+  const detailsResponse = await session.cardType(key)
 
   if (detailsResponse) {
     return NextResponse.json(detailsResponse)
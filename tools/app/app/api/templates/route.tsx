@@ -1,5 +1,5 @@
 import { NextResponse } from 'next/server'
-import { Show } from '@cyberismocom/data-handler/show'
+import { ProjectSession } from '@cyberismocom/data-handler/containers/project-session'
 
 export const dynamic = 'force-dynamic'
 
@@ -19,24 +19,24 @@ export const dynamic = 'force-dynamic'
  */
 export async function GET() {
   const projectPath = process.env.npm_config_project_path
-  const show = new Show()
   if (!projectPath) {
     return new NextResponse('project_path environment variable not set.', {
       status: 500,
     })
   }
 
+  const session = ProjectSession.getInstance(projectPath)
   try {
-    show.showProject(projectPath)
+    await session.show()
   } catch (error) {
     return new NextResponse(`No project found at path ${projectPath}`, {
       status: 500,
     })
   }
 
-  const response = await show.showTemplates(projectPath)
+  const response = await session.templates()
   if (response) {
-    return NextResponse.json(response)
+    return NextResponse.json(response.map((item) => item.name).sort())
   } else {
     return new NextResponse(`No templates found from path ${projectPath}`, {
       status: 500,
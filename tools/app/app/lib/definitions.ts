@@ -1,4 +1,6 @@
+import { calculationProfile } from '@cyberismocom/data-handler/calculate'
 import {
+  calculatedField,
   cardtype,
   workflowCategory,
 } from '@cyberismocom/data-handler/interfaces/project-interfaces'
@@ -27,6 +29,9 @@ export interface CardDetails {
   content?: string
   metadata?: CardMetadata
   attachments?: CardAttachment[]
+  calculations?: calculatedField[]
+  calculationJob?: number
+  profile?: calculationProfile
 }
 
 export type CardMetadata = {
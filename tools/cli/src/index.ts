@@ -84,10 +84,12 @@ program
     .command('calc')
     .description('Either generates or runs a logic program.')
     .argument('<subcommand>', subCalcCommandGuideline, parseCalcSubCommands)
-    .argument('[cardkey]', 'Cardkey of card; if omitted "calc generate" affects the whole cardtree. "calc run" always needs "card key"')
+    .argument('[cardkey]', 'Cardkey of card; if omitted "calc generate" affects the whole cardtree. "calc run" needs "card key", unless "--all" or "--ground-only" is used')
+    .option('-a, --all', 'Only for "run"; calculates all cards of the project in one pass. Results are grouped by card.')
     .option('-p, --project-path [path]', `${pathGuideline}`)
-    .option('-g, --ground-only', 'Only for "run"; ...')
-    .option('-s, --solve-only', 'Only for "run"; ...')
+    .option('-g, --ground-only', 'Only for "run"; grounds the logic program and stores it as text, so that later runs do not instantiate the rules again. Does not accept "cardkey".')
+    .option('--profile', 'Only for "run"; returns solver statistics (times, rule and atom counts, peak memory) of calculating the card, for the whole program and for each module.')
+    .option('-s, --solve-only', 'Only for "run"; solves using the stored grounded program. Fails, if the program has not been grounded, or cards or modules have changed since.')
     .action(async (subcommand: string, cardkey: string, options: CardsOptions) => {
         if (subcommand !== '') {
             const result = await commandHandler.command(Cmd.calc, [subcommand, cardkey], options);
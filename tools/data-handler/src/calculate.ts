@@ -1,39 +1,92 @@
 // node
-import { basename, join, sep } from 'node:path';
-import { Dirent } from 'node:fs';
-import { mkdir, opendir, readFile, writeFile } from 'node:fs/promises';
-import { spawnSync } from 'node:child_process';
+import { basename, join, resolve, sep } from 'node:path';
+import { mkdir, readFile, rm, writeFile } from 'node:fs/promises';
 
 // ismo
-import { card } from './interfaces/project-interfaces.js';
-import { deleteFile, pathExists } from './utils/file-utils.js';
+import { CalculationCache } from './utils/calculation-cache.js';
+import { calculationJob, CalculationQueue, queuedCalculationJob } from './utils/calculation-queue.js';
+import { calculatedField, card } from './interfaces/project-interfaces.js';
+import { CardIndex } from './containers/card-index.js';
+import { clingoQuery, ClingoEngine, solverStatistics } from './utils/clingo-engine.js';
+import { clingoFunction, ClingoOutputParser } from './utils/clingo-parser.js';
+import { FactStore } from './utils/fact-store.js';
+import { FactWriter } from './utils/fact-writer.js';
+import { pathExists } from './utils/file-utils.js';
 import { Project } from './containers/project.js';
 
-// Parsed Clingo result.
-interface ParseResult {
-    cardKey: string;
-    field: string;
-    value: string | number;
+/**
+ * Cards to calculate in one batch: list of card keys, a card with its descendants, or all cards.
+ */
+export type calculationTarget = string[] | { subtree: string } | 'all';
+
+/**
+ * Solver statistics of calculating one card. 'program' is the whole logic program; 'base' is the
+ * common definitions and card facts without modules. Each module is run on top of 'base' alone,
+ * so that its cost can be told apart from the other modules. Module that cannot be run alone
+ * has 'error' instead of statistics.
+ */
+export interface calculationProfile {
+    cardKey: string
+    program: solverStatistics
+    base: solverStatistics
+    modules: { file: string, statistics?: solverStatistics, error?: string }[]
+}
+
+// Card changes that are recalculated together. Either the whole logic program is generated again
+// ('all'), or facts of 'changed' cards are updated and facts of 'removed' cards are removed.
+// Cached results of 'affected' cards are removed in addition to those of the changed cards' cones.
+interface cardChanges {
+    all: boolean
+    changed: Set<string>
+    removed: Set<string>
+    affected: Set<string>
+}
+
+// Lookups that are shared by the cards whose facts are written in the same run.
+interface factContext {
+    project: Project
+    ancestors: Map<string, Promise<string[]>>
+    dataTypes: Map<string, Promise<string | undefined>>
+}
+
+// Recalculation that has been queued, but has not started yet.
+interface pendingRecalculation {
+    job: calculationJob
+    changes: cardChanges
 }
 
 // Class that calculates with logic program card / project level calculations.
 export class Calculate {
-    static project: Project;
 
-    private logicBinaryName: string = 'clingo';
     private static baseLogicFileName: string = 'base.lp';
     private static cardTreeFileName: string = 'cardtree.lp';
+    private static defaultFields: string[] = ['cardtype', 'summary', 'workflowState'];
     private static modulesFileName: string = 'modules.lp';
     private static mainLogicFileName: string = 'main.lp';
+    // Generating a large card tree can take a while.
+    static generateTimeout: number = 10 * 60 * 1000;
+    // When a subtree is generated, facts are written to the fact store after this many cards.
+    private static factBatchSize: number = 1000;
+    // Changes that arrive within 'recalculationDelay' milliseconds from each other are recalculated
+    // together; recalculation is not postponed for more than 'recalculationMaxDelay' milliseconds.
+    static recalculationDelay: number = 200;
+    static recalculationMaxDelay: number = 2000;
+    private static pendingRecalculations: Map<string, pendingRecalculation> = new Map();
+    // Background calculations of cards that have not finished yet; by project and card key.
+    private static pendingCardRuns: Map<string, Map<string, calculationJob>> = new Map();
+    // By default, a cached result is valid only until facts of any card change. When true,
+    // a cached result stays valid until facts of a card in its dependency cone change; this
+    // assumes that the calculations of modules do not relate cards outside of each other's cones.
+    static coneCaching: boolean = false;
+    // When true, 'ancestor', 'depth' and 'childCount' facts of cards are written from the card tree,
+    // so that clingo does not have to derive ancestors recursively. Changing this requires generating
+    // the logic program again.
+    static treeFacts: boolean = true;
     private static commonDefinitions: string = `
 %
 % Common definitions for all Cards projects
 %
 
-% parent and ancestor
-ancestor(A, C) :- parent(A, C), card(A), card(B).
-ancestor(A, C) :- parent(A, B), ancestor (B, C), card(A), card(B), card(C).
-
 % if the cardtype is given, then it's a card
 card(C) :- field(C, "cardtype", _).
 
@@ -45,6 +98,12 @@ userfield(Cardkey, "workflowState") :- field(Cardkey, "cardtype", Cardtype).
 % if all values of a field are cardkeys, then the field is of type "cardkeys"
 fieldtype(X, Field, "cardkeys") :- field(X, Field, _), card(Value) : field(X, Field, Value).
 
+`;
+    // Used when tree facts are not written; clingo derives ancestors from parents.
+    private static ancestorDefinitions: string = `
+% ancestor
+ancestor(A, C) :- parent(A, C).
+ancestor(A, C) :- parent(A, B), ancestor(B, C).
 `;
     private static mainLogicFile: string = `
 #include "base.lp".
@@ -56,21 +115,90 @@ fieldtype(X, Field, "cardkeys") :- field(X, Field, _), card(Value) : field(X, Fi
         // todo: set reusable paths here - problem is that project's path should be set
     }
 
-    // Write the base.lp that contains common definitions.
-    private async generateBase(parentCard: card | undefined) {
-        // When generating calculations for a specific module, do not generate common calculations.
-        if (parentCard) {
-            return;
+    // Returns true, if logic program has been generated.
+    private calculationsExist(project: Project): boolean {
+        const cardTreeFile = join(project.calculationFolder, Calculate.cardTreeFileName);
+        return pathExists(cardTreeFile) && pathExists(project.calculationFolder);
+    }
+
+    // Returns ancestors of a card, top level card first. Ancestors are looked up once per 'context'.
+    private ancestors(cardKey: string, context: factContext): Promise<string[]> {
+        let ancestors = context.ancestors.get(cardKey);
+        if (!ancestors) {
+            ancestors = context.project.cardIndex.find(cardKey).then(async entry =>
+                entry?.parent && entry.parent !== CardIndex.rootKey
+                    ? [...await this.ancestors(entry.parent, context), entry.parent]
+                    : []);
+            context.ancestors.set(cardKey, ancestors);
         }
-        const destinationFile = join(Calculate.project.calculationFolder, Calculate.baseLogicFileName);
-        await writeFile(destinationFile, Calculate.commonDefinitions, { encoding: 'utf-8', flag: 'w' });
+        return ancestors;
     }
 
-    // Write the cardtree.lp that contain data from the selected card-tree.
-    private async generateCardTreeContent(parentCard: card | undefined) {
-        const destinationFileBase = join(Calculate.project.calculationFolder, 'cards');
-        const promiseContainer = [];
+    // Calculates many cards of a project at once; see 'runBatch()'.
+    private async batch(project: Project, target: calculationTarget, solveOnly: boolean = false): Promise<{ [cardKey: string]: calculatedField[] }> {
+        let scope = project.cardrootFolder;
+        let cardKey: string | undefined;
+        let cardKeys: string[];
+        if (target === 'all') {
+            cardKeys = await project.cardIndex.keys();
+        } else {
+            if (Array.isArray(target)) {
+                cardKeys = [...new Set(target)];
+            } else {
+                const card = await project.cardIndex.find(target.subtree);
+                if (!card) {
+                    throw new Error(`Card '${target.subtree}' not found`);
+                }
+                scope = card.path;
+                cardKey = target.subtree;
+                cardKeys = await project.cardIndex.keys(target.subtree);
+            }
+            for (const key of cardKeys) {
+                if (!await project.cardIndex.find(key)) {
+                    throw new Error(`Card '${key}' not found`);
+                }
+            }
+        }
+        if (cardKeys.length === 0) {
+            return {};
+        }
+
+        const queued = this.queue(project).enqueue(
+            'run',
+            scope,
+            signal => this.solveCards(project, cardKeys, signal, solveOnly, target === 'all'),
+            { cardKey: cardKey, timeout: target === 'all' ? Calculate.generateTimeout : undefined });
 
+        const results: { [cardKey: string]: calculatedField[] } = {};
+        for (const [key, cardResults] of await queued.result) {
+            if (cardResults.length > 0) {
+                results[key] = cardResults;
+            }
+        }
+        return results;
+    }
+
+    // Returns results of cards that are up to date in the calculation cache. Cards whose results
+    // are not in the cache are 'unsolved'.
+    private async cachedResults(project: Project, cardKeys: string[]) {
+        const cache = this.resultCache(project);
+        const fingerprints = await this.cardFingerprints(project, cardKeys);
+        const results: Map<string, calculatedField[]> = new Map();
+        const unsolved: string[] = [];
+        for (const cardKey of cardKeys) {
+            const fingerprint = fingerprints.get(cardKey);
+            const cached = fingerprint ? await cache.get<calculatedField[]>(cardKey, fingerprint) : undefined;
+            if (cached) {
+                results.set(cardKey, cached);
+            } else {
+                unsolved.push(cardKey);
+            }
+        }
+        return { results: results, unsolved: unsolved, fingerprints: fingerprints };
+    }
+
+    // Returns logic program facts of a card.
+    private async cardFacts(card: card, context: factContext): Promise<string> {
         // Small helper to deduce parent path
         function parentPath(cardPath: string) {
             const pathParts = cardPath.split(sep);
@@ -81,74 +209,259 @@ fieldtype(X, Field, "cardkeys") :- field(X, Field, _), card(Value) : field(X, Fi
             }
         }
 
-        const cards = await this.getCards(parentCard);
-        for (const card of cards) {
-            let logicProgram = `\n% ${card.key}\n`;
-            const parentsPath = parentPath(card.path);
-
-            if (card.metadata) {
-                for (const [field, value] of Object.entries(card.metadata)) {
-                    if (field === "labels") {
-                        for (const label of value as Array<string>) {
-                            logicProgram += `label(${card.key}, "${label}").\n`;
-                        }
-                    } else {
-                        logicProgram += `field(${card.key}, "${field}", "${value}").\n`;
-                    }
+        const facts: string[] = [];
+        const parentsPath = parentPath(card.path);
+
+        if (card.metadata) {
+            for (const [field, value] of Object.entries(card.metadata)) {
+                if (field === "labels") {
+                    facts.push(...FactWriter.labelFacts(card.key, Array.isArray(value) ? value : []));
+                } else {
+                    facts.push(...FactWriter.fieldFacts(card.key, field, value, await this.dataType(field, context)));
                 }
             }
+        }
+
+        if (parentsPath !== undefined && parentsPath !== "") {
+            facts.push(`parent(${card.key}, ${parentsPath}).`);
+        }
+        if (Calculate.treeFacts) {
+            facts.push(...await this.treeFacts(card.key, context));
+        }
+        return facts.join('\n');
+    }
 
-            if (parentsPath !== undefined && parentsPath !== "") {
-                logicProgram += `parent(${card.key}, ${parentsPath}).\n`;
+    // Returns fingerprints of the inputs of card calculations: the rules, the query and the facts
+    // of all cards, or with 'coneCaching' the facts of the cards in each card's dependency cone.
+    // Cards that are not in the card tree do not get one.
+    private async cardFingerprints(project: Project, cardKeys: string[]): Promise<Map<string, string>> {
+        const cones: Map<string, string[]> = new Map();
+        for (const cardKey of cardKeys) {
+            const cone = await this.cone(project, cardKey);
+            if (cone.length > 0) {
+                cones.set(cardKey, cone);
+            }
+        }
+        const program = await this.programFingerprint(project);
+        const query = this.showQuery('')('');
+        const fingerprints: Map<string, string> = new Map();
+        if (!Calculate.coneCaching) {
+            const projectFacts = await this.factStore(project).fingerprint();
+            for (const cardKey of cones.keys()) {
+                fingerprints.set(cardKey, CalculationCache.fingerprint([program, query, projectFacts]));
             }
+            return fingerprints;
+        }
+
+        const facts = await this.factStore(project).facts([...new Set([...cones.values()].flat())]);
+        const factHashes: Map<string, string> = new Map();
+        for (const [cardKey, cardFacts] of facts) {
+            factHashes.set(cardKey, CalculationCache.fingerprint([cardFacts]));
+        }
+        for (const [cardKey, cone] of cones) {
+            const coneFacts = cone.map(key => `${key}:${factHashes.get(key) ?? ''}`);
+            fingerprints.set(cardKey, CalculationCache.fingerprint([program, query, ...coneFacts]));
+        }
+        return fingerprints;
+    }
+
+    // Returns project of a card.
+    private async cardProject(card: card): Promise<Project> {
+        const path = await Project.findProjectRoot(card.path);
+        if (!path) {
+            throw `Card '${card.key}' not in project structure`;
+        }
+        return new Project(path);
+    }
+
+    // Returns facts of each card of the selected card-tree, as [card key, facts] pairs.
+    private async *cardTreeFacts(project: Project, parentCard: card | undefined, signal?: AbortSignal): AsyncGenerator<[string, string]> {
+        const context = Calculate.factContext(project);
+        for await (const card of this.iterateCards(project, parentCard)) {
+            // Stop, if the job was cancelled or it timed out.
+            signal?.throwIfAborted();
+            yield [card.key, await this.cardFacts(card, context)];
+        }
+        signal?.throwIfAborted();
+    }
+
+    // Returns dependency cone of a card: its ancestors, the card itself and its descendants.
+    // Calculated fields of a card can depend on facts of these cards; a change in any other card
+    // does not change them. Empty, if the card is not in the card tree.
+    private async cone(project: Project, cardKey: string): Promise<string[]> {
+        const subtree = await project.cardIndex.keys(cardKey);
+        if (subtree.length === 0) {
+            return [];
+        }
+        return [...await this.ancestors(cardKey, Calculate.factContext(project)), ...subtree];
+    }
 
-            // write card-specific logic program file
-            const filename = join(destinationFileBase, card.key);
-            const cardLogicFile = `${filename}.lp`;
-            promiseContainer.push(writeFile(cardLogicFile, logicProgram, { encoding: 'utf-8', flag: 'w' }));
+    // Returns data type of a metadata field; undefined for the default fields and for fields
+    // that do not have a field type.
+    private dataType(field: string, context: factContext): Promise<string | undefined> {
+        let dataType = context.dataTypes.get(field);
+        if (!dataType) {
+            dataType = Calculate.defaultFields.includes(field)
+                ? Promise.resolve(undefined)
+                : context.project.fieldType(field).then(fieldType => fieldType?.dataType, () => undefined);
+            context.dataTypes.set(field, dataType);
         }
+        return dataType;
+    }
+
+    // Generates logic program files; whole tree, or only a subtree if 'card' is given.
+    private async doGenerate(project: Project, card: card | undefined, signal: AbortSignal) {
+        await mkdir(project.calculationFolder, { recursive: true });
+
+        // Calculation files are in their own files, so they can be generated parallel.
+        const promiseContainer = [
+            this.generateBase(project, card),
+            this.generateCardTreeContent(project, card, signal).then(() => this.genereteCardTree(project)),
+            this.generateModules(project, card),
+            this.generateMainLogicFile(project, card)
+        ];
+
         await Promise.all(promiseContainer);
+        if (card) {
+            await this.resultCache(project).remove(await this.cone(project, card.key));
+        } else {
+            await this.resultCache(project).clear();
+        }
+        this.engine(project).invalidate();
     }
 
-    // Once card specific files have been done, write the cardtree.lp.
-    private async genereteCardTree() {
-        const destinationFile = join(Calculate.project.calculationFolder, Calculate.cardTreeFileName);
-        const destinationFileBase = join(Calculate.project.calculationFolder, 'cards');
+    // Recalculates changes: either generates the whole logic program, or updates facts of the changed
+    // cards. Cards that had cached results, which are no longer valid, are calculated again in the background.
+    private async doRecalculate(project: Project, changes: cardChanges, signal: AbortSignal) {
+        if (changes.all) {
+            await this.doGenerate(project, undefined, signal);
+            return;
+        }
+        const invalidated = await this.doUpdateCards(project, changes, signal);
+        const cardKeys: string[] = [];
+        for (const cardKey of invalidated) {
+            if (await project.cardIndex.find(cardKey)) {
+                cardKeys.push(cardKey);
+            }
+        }
+        if (cardKeys.length > 0) {
+            this.queue(project).enqueue(
+                'run',
+                project.cardrootFolder,
+                signal => this.solveCards(project, cardKeys, signal));
+        }
+    }
 
-        // Helper to remove extension from filename.
-        function removeExtension(dirent: Dirent) {
-            const name = dirent.name;
-            const index = name.lastIndexOf(".");
-            return (index === -1) ? name : name.substring(0, index);
+    // Writes facts of changed cards and removes facts of removed cards; facts of other cards
+    // are not touched. Returns the cards whose cached results were removed.
+    private async doUpdateCards(project: Project, changes: cardChanges, signal: AbortSignal): Promise<string[]> {
+        const facts: Map<string, string> = new Map();
+        const removed: string[] = [...changes.removed];
+        const context = Calculate.factContext(project);
+        for (const cardKey of changes.changed) {
+            signal.throwIfAborted();
+            // Card is read when the job runs, so that the latest metadata is used.
+            const card = await project.findSpecificCard(cardKey, { metadata: true });
+            if (card) {
+                facts.set(card.key, await this.cardFacts(card, context));
+            } else {
+                removed.push(cardKey);
+            }
         }
+        signal.throwIfAborted();
 
-        const files = await opendir(destinationFileBase);
-        let cardTreeContent: string = '';
-        for await (const file of files) {
-            cardTreeContent += `#include "cards/${removeExtension(file)}.lp".\n`;
+        const factStore = this.factStore(project);
+        await factStore.update(facts);
+        if (removed.length > 0) {
+            await factStore.remove(removed);
+        }
+        // Results of the cards whose dependency cone includes a changed card are removed. Without
+        // 'coneCaching', results of the other cards are outdated as well, since their fingerprint changes.
+        const affected = new Set([...removed, ...changes.affected]);
+        for (const cardKey of facts.keys()) {
+            (await this.cone(project, cardKey)).forEach(key => affected.add(key));
         }
+        const invalidated = await this.resultCache(project).remove([...affected]);
+        this.engine(project).invalidate();
+        return invalidated;
+    }
+
+    // Returns engine that runs the project's logic program.
+    private engine(project: Project): ClingoEngine {
+        return ClingoEngine.getInstance(join(project.calculationFolder, Calculate.mainLogicFileName));
+    }
+
+    // Returns empty lookups for writing facts of the project's cards.
+    private static factContext(project: Project): factContext {
+        return { project: project, ancestors: new Map(), dataTypes: new Map() };
+    }
+
+    // Returns store of card facts.
+    private factStore(project: Project): FactStore {
+        return new FactStore(project.calculationFolder);
+    }
+
+    // Write the base.lp that contains common definitions.
+    private async generateBase(project: Project, parentCard: card | undefined) {
+        // When generating calculations for a specific module, do not generate common calculations.
+        if (parentCard) {
+            return;
+        }
+        const destinationFile = join(project.calculationFolder, Calculate.baseLogicFileName);
+        const definitions = Calculate.commonDefinitions + (Calculate.treeFacts ? '' : Calculate.ancestorDefinitions);
+        await writeFile(destinationFile, definitions, { encoding: 'utf-8', flag: 'w' });
+    }
+
+    // Write the facts of the selected card-tree to the fact store. Facts are written as the cards
+    // are read, so that facts of the whole tree are not kept in memory.
+    private async generateCardTreeContent(project: Project, parentCard: card | undefined, signal?: AbortSignal) {
+        const facts = this.cardTreeFacts(project, parentCard, signal);
+        if (!parentCard) {
+            await this.factStore(project).replaceAllFrom(facts);
+            // Remove per-card files of earlier versions.
+            await rm(join(project.calculationFolder, 'cards'), { recursive: true, force: true });
+            return;
+        }
+        // Other cards keep their facts, so subtree is written to the shards in batches.
+        let batch: Map<string, string> = new Map();
+        for await (const [cardKey, cardFacts] of facts) {
+            batch.set(cardKey, cardFacts);
+            if (batch.size >= Calculate.factBatchSize) {
+                await this.factStore(project).update(batch);
+                batch = new Map();
+            }
+        }
+        await this.factStore(project).update(batch);
+    }
+
+    // Once card facts have been written, write the cardtree.lp that includes them.
+    private async genereteCardTree(project: Project) {
+        const destinationFile = join(project.calculationFolder, Calculate.cardTreeFileName);
+        const cardTreeContent = this.factStore(project).files()
+            .map(file => `#include "${file}".\n`)
+            .join('');
         await writeFile(destinationFile, cardTreeContent, { encoding: 'utf-8', flag: 'w' });
     }
 
     // Write the main.lp that includes all other logic programs.
-    private async generateMainLogicFile(parentCard: card | undefined) {
+    private async generateMainLogicFile(project: Project, parentCard: card | undefined) {
         // When generating calculations for a specific module, do not generate common calculations.
         if (parentCard) {
             return;
         }
-        const destinationFile = join(Calculate.project.calculationFolder, Calculate.mainLogicFileName);
+        const destinationFile = join(project.calculationFolder, Calculate.mainLogicFileName);
         await writeFile(destinationFile, Calculate.mainLogicFile, { encoding: 'utf-8', flag: 'w' });
     }
 
     // Collects all logic calculation files from project (local and imported modules)
-    private async generateModules(parentCard: card | undefined) {
+    private async generateModules(project: Project, parentCard: card | undefined) {
         // When generating calculations for a specific module, do not generate common calculations.
         if (parentCard) {
             return;
         }
-        const destinationFile = join(Calculate.project.calculationFolder, Calculate.modulesFileName);
+        const destinationFile = join(project.calculationFolder, Calculate.modulesFileName);
         let modulesContent: string = '';
-        const calculations = await Calculate.project.calculations();
+        const calculations = await project.calculations();
 
         // write the modules.lp
         for (const calculationFile of calculations) {
@@ -161,67 +474,283 @@ fieldtype(X, Field, "cardkeys") :- field(X, Field, _), card(Value) : field(X, Fi
         await writeFile(destinationFile, modulesContent, { encoding: 'utf-8', flag: 'w' });
     }
 
-    // Gets either all the cards (no parent), or a subtree.
-    private async getCards(parentCard: card | undefined): Promise<card[]> {
-        let cards: card[] = [];
-        if (parentCard) {
-            const card = await Calculate.project.findSpecificCard(
-                parentCard.key,
-                { metadata: true, children: true, content: false, parent: false }
-            );
-            if (card && card.children) {
-                cards = Project.flattenCardArray(card.children);
+    // Iterates either all the cards (no parent), or a subtree. Cards have only metadata.
+    private iterateCards(project: Project, parentCard: card | undefined): AsyncGenerator<card> {
+        return project.iterateCards({ metadata: true }, parentCard?.key);
+    }
+
+    // Returns parents of cards. When tree facts are written, facts of the parents change as well,
+    // if cards are added or removed, because the number of children changes.
+    private async parentKeys(project: Project, cardKeys: string[]): Promise<string[]> {
+        if (!Calculate.treeFacts) {
+            return [];
+        }
+        const parents: Set<string> = new Set();
+        for (const cardKey of cardKeys) {
+            const entry = await project.cardIndex.find(cardKey);
+            if (entry?.parent && entry.parent !== CardIndex.rootKey) {
+                parents.add(entry.parent);
             }
-            if (card) {
-                delete card.children;
-                cards.unshift(card);
+        }
+        return [...parents];
+    }
+
+    // Runs the card's query with each part of the logic program and collects solver statistics.
+    private async profileCard(project: Project, cardKey: string, signal: AbortSignal): Promise<calculationProfile> {
+        const folder = project.calculationFolder;
+        const engine = this.engine(project);
+        const query = this.showQuery(`Cardkey = ${cardKey}`);
+        const base = [Calculate.baseLogicFileName, Calculate.cardTreeFileName].map(file => join(folder, file));
+        const modules = await readFile(join(folder, Calculate.modulesFileName), { encoding: 'utf-8' }).catch(() => '');
+
+        const profile: calculationProfile = {
+            cardKey: cardKey,
+            program: await engine.profile([], query, signal),
+            base: await engine.profile(base, query, signal),
+            modules: [],
+        };
+        // Modules are run one at a time, so that they do not affect each other's times.
+        for (const match of modules.matchAll(/#include\s+"([^"]+)"/g)) {
+            const file = resolve(folder, match[1]);
+            try {
+                profile.modules.push({ file: file, statistics: await engine.profile([...base, file], query, signal) });
+            } catch (error) {
+                signal.throwIfAborted();
+                profile.modules.push({ file: file, error: (error as Error).message });
             }
-        } else {
-            cards = await Calculate.project.cards();
         }
-        return cards;
+        return profile;
     }
 
-    // Checks that Clingo successfully returned result.
-    private async parseClingoResult(data: string): Promise<ParseResult[] | undefined> {
-        const actual_result = data.substring(0, data.indexOf('SATISFIABLE'));
-        if (actual_result.length === 0 || !actual_result) {
-            return;
+    // Returns fingerprint of the rules of the logic program: common definitions and module calculations.
+    private async programFingerprint(project: Project): Promise<string> {
+        const folder = project.calculationFolder;
+        const read = (file: string) => readFile(file, { encoding: 'utf-8' }).catch(() => '');
+        const files = [Calculate.mainLogicFileName, Calculate.baseLogicFileName, Calculate.modulesFileName]
+            .map(file => join(folder, file));
+        const modules = await read(join(folder, Calculate.modulesFileName));
+        files.push(...[...modules.matchAll(/#include\s+"([^"]+)"/g)].map(match => resolve(folder, match[1])));
+        const contents = await Promise.all(files.map(file => read(file)));
+        return CalculationCache.fingerprint(files.flatMap((file, index) => [file, contents[index]]));
+    }
+
+    // Returns those of 'cardKeys' that are in the card tree of the project.
+    private async projectCards(project: Project, cardKeys: string[]): Promise<string[]> {
+        const projectCards: string[] = [];
+        for (const cardKey of cardKeys) {
+            if (await project.cardIndex.find(cardKey)) {
+                projectCards.push(cardKey);
+            }
+        }
+        return projectCards;
+    }
+
+    // Returns calculation job queue of the project.
+    private queue(project: Project): CalculationQueue {
+        return CalculationQueue.getInstance(project.basePath);
+    }
+
+    // Queues calculating cards in the background. Cards that are already being calculated
+    // are not queued again. Returns the job that calculates the cards.
+    private queueCardRun(project: Project, cardKeys: string[]): calculationJob {
+        let pending = Calculate.pendingCardRuns.get(project.basePath);
+        if (!pending) {
+            pending = new Map();
+            Calculate.pendingCardRuns.set(project.basePath, pending);
         }
-        const parseResult = this.parseInput(actual_result);
-        return parseResult;
+        const cards = pending;
+        const missing = cardKeys.filter(cardKey => !cards.has(cardKey));
+        if (missing.length === 0) {
+            return cards.get(cardKeys[0])!;
+        }
+        const queued = this.queue(project).enqueue(
+            'run',
+            project.cardrootFolder,
+            signal => this.solveCards(project, missing, signal),
+            { cardKey: missing.length === 1 ? missing[0] : undefined });
+        missing.forEach(cardKey => cards.set(cardKey, queued.job));
+        // Failure is reported in the job status.
+        const finished = () => missing
+            .filter(cardKey => cards.get(cardKey) === queued.job)
+            .forEach(cardKey => cards.delete(cardKey));
+        queued.result.then(finished, finished);
+        return queued.job;
+    }
+
+    // Queues generating the logic program. Newer job of the same subtree replaces earlier ones.
+    private queueGenerate(project: Project, card: card | undefined): queuedCalculationJob<void> {
+        return this.queue(project).enqueue(
+            'generate',
+            card ? card.path : project.cardrootFolder,
+            signal => this.doGenerate(project, card, signal),
+            { cardKey: card?.key, exclusive: true, supersede: true, timeout: Calculate.generateTimeout });
     }
 
-    // Parses Clingo's result to an array of objects (key, field, value).
-    private parseInput(input: string): ParseResult[] {
-        const regex = /(field|fieldtype)\(([a-zA-Z0-9_]+),"([a-zA-Z0-9_]+)",([a-zA-Z0-9_" ]+)/;
-        const results: ParseResult[] = []
+    // Returns cache of calculation results.
+    private resultCache(project: Project): CalculationCache {
+        return new CalculationCache(project.calculationFolder);
+    }
 
-        for (const datum of input.split('\n')) {
-            if (datum) {
-                const match = datum.match(regex);
-                if (match) {
-                    results.push({
-                        cardKey: match[2],
-                        field: match[3],
-                        value: match[4]
-                    });
+    // Adds changes to the project's pending recalculation, or queues a new one. Recalculation waits
+    // until no changes have arrived for 'recalculationDelay', so that changes made in quick
+    // succession (e.g. editing many cards) are recalculated together.
+    private scheduleRecalculation(project: Project, merge: (changes: cardChanges) => void): calculationJob {
+        const queue = this.queue(project);
+        const pending = Calculate.pendingRecalculations.get(project.basePath);
+        if (pending && queue.job(pending.job.id)?.state === 'queued') {
+            merge(pending.changes);
+            const waitLeft = Calculate.recalculationMaxDelay - (Date.now() - pending.job.queued);
+            queue.postpone(pending.job.id, Math.max(0, Math.min(Calculate.recalculationDelay, waitLeft)));
+            return pending.job;
+        }
+
+        const changes: cardChanges = { all: false, changed: new Set(), removed: new Set(), affected: new Set() };
+        merge(changes);
+        let recalculation: pendingRecalculation | undefined = undefined;
+        const queued = queue.enqueue(
+            'update',
+            project.cardrootFolder,
+            signal => {
+                // Changes that arrive from now on are recalculated by the next job.
+                if (Calculate.pendingRecalculations.get(project.basePath) === recalculation) {
+                    Calculate.pendingRecalculations.delete(project.basePath);
                 }
+                return this.doRecalculate(project, changes, signal);
+            },
+            { delay: Calculate.recalculationDelay, exclusive: true, timeout: Calculate.generateTimeout });
+        recalculation = { job: queued.job, changes: changes };
+        Calculate.pendingRecalculations.set(project.basePath, recalculation);
+        return queued.job;
+    }
+
+    // Returns query that shows calculated fields of cards that match the 'condition'.
+    private showQuery(condition: string): clingoQuery {
+        const cardCondition = condition ? `${condition},` : '';
+        return (guard: string) =>
+            `
+            #show.
+            #show field(Cardkey, Field, Value):
+                field(Cardkey, Field, Value),
+                ${cardCondition}
+                not userfield(Cardkey, Field),
+                ${guard}.
+            #show fieldtype(Cardkey, Field, Fieldtype):
+                fieldtype(Cardkey, Field, Fieldtype),
+                ${cardCondition}
+                not userfield(Cardkey, Field),
+                ${guard}.`;
+    }
+
+    // Calculates cards. Results of cards whose inputs have not changed are taken from the cache;
+    // the rest of the cards are calculated with one solve. With 'solveOnly', the logic program
+    // must have been grounded with 'ground()'. With 'allCards', 'cardKeys' are all cards of the
+    // project, and the query does not list them.
+    private async solveCards(project: Project, cardKeys: string[], signal: AbortSignal, solveOnly: boolean = false, allCards: boolean = false): Promise<Map<string, calculatedField[]>> {
+        if (solveOnly && !await this.engine(project).grounded()) {
+            throw new Error('Logic program has not been grounded, or it has changed since. Use "calc run --ground-only" first.');
+        }
+        const cache = this.resultCache(project);
+        const { results, unsolved, fingerprints } = await this.cachedResults(project, cardKeys);
+        for (const cardKey of unsolved) {
+            results.set(cardKey, []);
+        }
+        if (unsolved.length === 0) {
+            return results;
+        }
+
+        // Pool expands to one condition per card. When all cards are calculated, a condition
+        // would only slow down grounding; results of cached cards are ignored instead.
+        const query = this.showQuery(allCards ? '' : `Cardkey = (${unsolved.join(';')})`);
+        const solving = new Set(unsolved);
+        // Output is parsed as it arrives.
+        const parser = new ClingoOutputParser(symbol => {
+            const result = Calculate.toCalculatedField(symbol);
+            if (result && solving.has(result.cardKey)) {
+                results.get(result.cardKey)?.push(result);
             }
+        });
+        await this.engine(project).solve(query, signal, chunk => parser.write(chunk));
+        if (parser.end() === 'SATISFIABLE') {
+            await Promise.all(unsolved
+                .filter(cardKey => fingerprints.has(cardKey))
+                .map(cardKey => cache.set(cardKey, fingerprints.get(cardKey)!, results.get(cardKey))));
         }
         return results;
     }
 
-    // Creates a project, if it is not already created.
-    private async setCalculateProject(card: card) {
-        if (!Calculate.project) {
-            const path = await Project.findProjectRoot(card.path);
-            if (path) {
-                Calculate.project = new Project(path);
-            } else {
-                throw `Card '${card.key}' not in project structure`;
+    // Converts a shown 'field' or 'fieldtype' atom to a calculated field. Other atoms are ignored.
+    private static toCalculatedField(symbol: clingoFunction): calculatedField | undefined {
+        const [card, field, value] = symbol.args;
+        if ((symbol.name !== 'field' && symbol.name !== 'fieldtype') || symbol.args.length !== 3 ||
+            typeof card !== 'object' || card.args.length > 0 || typeof field !== 'string') {
+            return undefined;
+        }
+        return {
+            cardKey: card.name,
+            field: field,
+            value: typeof value === 'object' ? ClingoOutputParser.text(value) : value,
+        };
+    }
+
+    // Returns facts of a card's place in the card tree: its ancestors, depth (0 for top level
+    // cards) and number of children.
+    private async treeFacts(cardKey: string, context: factContext): Promise<string[]> {
+        const ancestors = await this.ancestors(cardKey, context);
+        const children = await context.project.cardIndex.children(cardKey) ?? [];
+        return [
+            ...ancestors.map(ancestor => `ancestor(${cardKey}, ${ancestor}).`),
+            `depth(${cardKey}, ${ancestors.length}).`,
+            `childCount(${cardKey}, ${children.length}).`,
+        ];
+    }
+
+    /**
+     * Returns calculated fields of cards from the calculation cache, without waiting for the solver.
+     * Cards that are not in the cache are calculated in the background; their results can be
+     * fetched again once 'job' has finished. Solver is not run, if the logic program has not
+     * been generated.
+     * @param {Project} project Project of the cards
+     * @param {string[]} cardKeys Cards; cards that are not in the card tree (e.g. template cards) do not have calculated fields.
+     * @returns calculated fields of the cached cards; cards without calculated fields are not included.
+     *          'job' is the calculation job of the cards that were not in the cache, if there are any.
+     */
+    public async cachedCardCalculations(project: Project, cardKeys: string[]): Promise<{ calculations: { [cardKey: string]: calculatedField[] }, job?: calculationJob }> {
+        const projectCards = await this.projectCards(project, cardKeys);
+        if (projectCards.length === 0 || !this.calculationsExist(project)) {
+            return { calculations: {} };
+        }
+        const { results, unsolved } = await this.cachedResults(project, projectCards);
+        const calculations: { [cardKey: string]: calculatedField[] } = {};
+        for (const [cardKey, cardResults] of results) {
+            if (cardResults.length > 0) {
+                calculations[cardKey] = cardResults;
             }
         }
+        if (unsolved.length === 0) {
+            return { calculations: calculations };
+        }
+        return { calculations: calculations, job: this.queueCardRun(project, unsolved) };
+    }
+
+    /**
+     * Returns calculated fields of cards. Results come from the calculation cache; cards that
+     * are not in the cache are calculated together with one solve. Solver is not run, if the
+     * logic program has not been generated.
+     * @param {Project} project Project of the cards
+     * @param {string[]} cardKeys Cards; cards that are not in the card tree (e.g. template cards) do not have calculated fields.
+     * @returns calculated fields of each card; cards without calculated fields are not included.
+     */
+    public async cardCalculations(project: Project, cardKeys: string[]): Promise<{ [cardKey: string]: calculatedField[] }> {
+        const projectCards = await this.projectCards(project, cardKeys);
+        if (projectCards.length === 0 || !this.calculationsExist(project)) {
+            return {};
+        }
+        try {
+            return await this.batch(project, projectCards);
+        } catch {
+            // Card can be shown without calculated fields; failure is reported in the job status.
+            return {};
+        }
     }
 
     /**
@@ -230,38 +759,55 @@ fieldtype(X, Field, "cardkeys") :- field(X, Field, _), card(Value) : field(X, Fi
      * @param {string} cardKey Optional, sub-card tree defining card
      */
     public async generate(projectPath: string, cardKey?: string) {
-        Calculate.project = new Project(projectPath);
+        const project = new Project(projectPath);
 
         let card: card | undefined;
         if (cardKey) {
-            card = await Calculate.project.findSpecificCard(cardKey);
+            card = await project.findSpecificCard(cardKey);
             if (!card) {
                 throw new Error(`Card '${cardKey}' not found`);
             }
         }
 
-        await mkdir(join(Calculate.project.calculationFolder, 'cards'), { recursive: true });
-
-        // Calculation files are in their own files, so they can be generated parallel.
-        const promiseContainer = [
-            this.generateBase(card),
-            this.generateCardTreeContent(card),
-            this.genereteCardTree(),
-            this.generateModules(card),
-            this.generateMainLogicFile(card)
-        ];
+        await this.queueGenerate(project, card).result;
+    }
 
-        await Promise.all(promiseContainer);
+    /**
+     * Grounds the logic program ahead of time. Grounded program is stored as text in the calculation
+     * folder, and queries load it instead of the program, until cards or modules change. Loading the
+     * grounded program still parses its ground rules, but rules are not instantiated again.
+     * @param {string} projectPath Path to a project
+     */
+    public async ground(projectPath: string) {
+        const project = new Project(projectPath);
+        if (!this.calculationsExist(project)) {
+            throw new Error('Logic program has not been generated. Use "calc generate" first.');
+        }
+        await this.queue(project).enqueue(
+            'ground',
+            project.cardrootFolder,
+            signal => this.engine(project).ground(signal),
+            { timeout: Calculate.generateTimeout }).result;
     }
 
     /**
      * When card changes, update the card specific calculations.
+     * Only the facts of the changed card are updated, in the background. Changes that arrive
+     * in quick succession are recalculated together.
      * @param {card} changedCard Card that was changed.
+     * @returns status of the queued calculation job.
      */
     public async handleCardChanged(changedCard: card) {
-        await this.setCalculateProject(changedCard); // can throw
-        await this.generate(Calculate.project.basePath, changedCard.key);
-        return { statusCode: 200 };
+        const project = await this.cardProject(changedCard); // can throw
+        if (!this.calculationsExist(project)) {
+            // No calculations done, ignore update.
+            return { statusCode: 200 };
+        }
+        const job = this.scheduleRecalculation(project, changes => {
+            changes.removed.delete(changedCard.key);
+            changes.changed.add(changedCard.key);
+        });
+        return { statusCode: 200, payload: job };
     }
 
     /**
@@ -273,118 +819,152 @@ fieldtype(X, Field, "cardkeys") :- field(X, Field, _), card(Value) : field(X, Fi
             return;
         }
 
-        await this.setCalculateProject(deletedCard); // can throw
-        const affectedCards = await this.getCards(deletedCard);
-        const cardTreeFile = join(Calculate.project.calculationFolder, Calculate.cardTreeFileName);
-        const calculationsForTreeExist = pathExists(cardTreeFile) && pathExists(Calculate.project.calculationFolder);
-
-        let cardTreeContent = calculationsForTreeExist ? await readFile(cardTreeFile, 'utf-8') : '';
-        for (const card of affectedCards) {
-            // First, delete card specific files.
-            const cardCalculationsFile = join(Calculate.project.calculationFolder, 'cards', `${card.key}.lp`);
-            if (pathExists(cardCalculationsFile)) {
-                await deleteFile(cardCalculationsFile);
-            }
-            // Then, delete rows from cardtree.lp.
-            const removeRow = `#include "cards/${card.key}.lp".\n`;
-            cardTreeContent = cardTreeContent.replace(removeRow, '');
+        const project = await this.cardProject(deletedCard); // can throw
+        if (!this.calculationsExist(project)) {
+            return;
         }
-        if (calculationsForTreeExist) {
-            await writeFile(cardTreeFile, cardTreeContent, 'utf-8');
+
+        // Collect the cards before they are removed; their facts are removed in the background.
+        // Card index knows the subtree without reading the cards. Template cards do not have facts.
+        const cardKeys = await project.cardIndex.keys(deletedCard.key);
+        if (cardKeys.length === 0) {
+            return;
         }
+        // Ancestors lose the subtree, so their results are removed from the cache, too.
+        const affected = await this.cone(project, deletedCard.key);
+        const parents = await this.parentKeys(project, [deletedCard.key]);
+        this.scheduleRecalculation(project, changes => {
+            for (const cardKey of cardKeys) {
+                changes.changed.delete(cardKey);
+                changes.removed.add(cardKey);
+            }
+            affected.forEach(cardKey => changes.affected.add(cardKey));
+            parents.filter(cardKey => !changes.removed.has(cardKey)).forEach(cardKey => changes.changed.add(cardKey));
+        });
     }
 
     /**
     * When new cards are added, automatically calculate card-specific values.
+    * Only the facts of the added cards, and of their parents, are written in the background.
     * @param {card[]} cards Added cards.
     */
     public async handleNewCards(cards: card[]) {
-        if (!cards) {
+        if (!cards || cards.length === 0) {
             return;
         }
 
         const firstCard = cards[0];
-        await this.setCalculateProject(firstCard); // can throw
-        const cardTreeFile = join(Calculate.project.calculationFolder, Calculate.cardTreeFileName);
-        const calculationsForTreeExist = pathExists(cardTreeFile) && pathExists(Calculate.project.calculationFolder);
-        if (!calculationsForTreeExist) {
+        const project = await this.cardProject(firstCard); // can throw
+        if (!this.calculationsExist(project)) {
             // No calculations done, ignore update.
             return;
         }
+        const parents = await this.parentKeys(project, cards.map(card => card.key));
+        this.scheduleRecalculation(project, changes => {
+            for (const card of cards) {
+                changes.removed.delete(card.key);
+                changes.changed.add(card.key);
+            }
+            parents.filter(cardKey => !changes.removed.has(cardKey)).forEach(cardKey => changes.changed.add(cardKey));
+        });
+    }
 
-        // @todo - should only generate card-tree for created cards' common ancestor (or root)
-        //         this might in some cases (sub-tree created) improve performance
-        await this.generateCardTreeContent(undefined);
-        await this.genereteCardTree();
+    /**
+     * When project changes as a whole (e.g. it is renamed), the logic program is generated again.
+     * Regeneration replaces the other pending changes.
+     * @param {string} projectPath Path to a project
+     * @returns status of the queued calculation job.
+     */
+    public async handleProjectChanged(projectPath: string) {
+        const job = this.scheduleRecalculation(new Project(projectPath), changes => {
+            changes.all = true;
+        });
+        return { statusCode: 200, payload: job };
     }
 
     /**
-     * Runs a logic program.
+     * Returns status of a calculation job.
+     * @param {string} projectPath Path to a project
+     * @param {number} id Job id
+     * @returns job status, or undefined if job is not known.
+     */
+    public job(projectPath: string, id: number): calculationJob | undefined {
+        return CalculationQueue.getInstance(projectPath).job(id);
+    }
+
+    /**
+     * Returns status of queued, running and recently finished calculation jobs.
+     * @param {string} projectPath Path to a project
+     * @returns job statuses, oldest first.
+     */
+    public jobs(projectPath: string): calculationJob[] {
+        return CalculationQueue.getInstance(projectPath).jobs();
+    }
+
+    /**
+     * Profiles calculating a card. The card's query is run with the whole logic program, with
+     * the program without modules, and with each module alone, and solver statistics
+     * (times, rule and atom counts, and peak memory) of each run are returned.
+     * Results are not cached, and clingo is always run as a new process.
+     * @param {string} projectPath Path to a project
+     * @param {string} cardKey Card to calculate
+     * @returns solver statistics of each run.
+     */
+    public async profile(projectPath: string, cardKey: string): Promise<calculationProfile> {
+        const project = new Project(projectPath);
+        const card = await project.findSpecificCard(cardKey);
+        if (!card) {
+            throw new Error(`Card '${cardKey}' not found`);
+        }
+        if (!this.calculationsExist(project)) {
+            throw new Error('Logic program has not been generated. Use "calc generate" first.');
+        }
+        return this.queue(project).enqueue(
+            'profile',
+            card.path,
+            signal => this.profileCard(project, card.key, signal),
+            { cardKey: card.key, timeout: Calculate.generateTimeout }).result;
+    }
+
+    /**
+     * Runs a logic program. Results are cached; card is calculated again when facts of the cards,
+     * or the calculation rules change. With 'coneCaching', card is calculated again only when facts of
+     * the cards in its dependency cone (its ancestors and descendants) change.
      *
      * @param {string} projectPath Path to a project
      * @param {string} cardKey Optional, if missing the calculations are run for the whole cardtree.
      *                         If defined, calculates only subtree.
+     * @param {boolean} solveOnly Optional, use only the program grounded with 'ground()'; fails, if it is outdated.
      * @returns parsed program output
      */
-    public async run(projectPath: string, cardKey: string): Promise<ParseResult[] | undefined> {
-        Calculate.project = new Project(projectPath);
+    public async run(projectPath: string, cardKey: string, solveOnly: boolean = false): Promise<calculatedField[] | undefined> {
+        const project = new Project(projectPath);
 
-        const card = await Calculate.project.findSpecificCard(cardKey);
+        const card = await project.findSpecificCard(cardKey);
         if (!card) {
             throw new Error(`Card '${cardKey}' not found`);
         }
 
-        const text =
-            `
-            #show.
-            #show field(Cardkey, Field, Value):
-                field(Cardkey, Field, Value),
-                Cardkey = ${card.key},
-                not userfield(Cardkey, Field).
-            #show fieldtype(Cardkey, Field, Fieldtype):
-                fieldtype(Cardkey, Field, Fieldtype),
-                Cardkey = ${card.key},
-                not userfield(Cardkey, Field).`;
-        const main = join(Calculate.project.calculationFolder, Calculate.mainLogicFileName);
-        const clingo = spawnSync(this.logicBinaryName, ['-', '--outf=0', '--out-ifs=\\n', '-V0', `${main}`], { encoding: 'utf8', input: text });
-
-        if (clingo.stdout) {
-            const result = await this.parseClingoResult(clingo.stdout);
-            return result;
-        }
-
-        if (clingo.stderr && clingo.status) {
-            const code = clingo.status
-            // clingo's exit codes are bitfields. todo: move these somewhere
-            const clingo_process_exit = {
-                E_UNKNOWN: 0,
-                E_INTERRUPT: 1,
-                E_SAT: 10,
-                E_EXHAUST: 20,
-                E_MEMORY: 33,
-                E_ERROR: 65,
-                E_NO_RUN: 128,
-            };
-            // "satisfied" && "exhaust" mean that everything was inspected and a solution was found.
-            if (!((code & clingo_process_exit.E_SAT) && (code & clingo_process_exit.E_EXHAUST))) {
-                if (code & clingo_process_exit.E_ERROR) {
-                    console.error('Error');
-                }
-                if (code & clingo_process_exit.E_INTERRUPT) {
-                    console.error('Interrupted');
-                }
-                if (code & clingo_process_exit.E_MEMORY) {
-                    console.error('Out of memory');
-                }
-                if (code & clingo_process_exit.E_NO_RUN) {
-                    console.error('Not run');
-                }
-                if (code & clingo_process_exit.E_UNKNOWN) {
-                    console.error('Unknown error');
-                }
-            }
-            throw new Error('Clingo error');
-        }
-        throw new Error('Cannot find "Clingo". Please install "Clingo".\nIf using MacOs: "brew install clingo".\nIf using Windows: download sources and compile new version.\nIf using Linux: check if your distribution contains pre-built package. Otherwise download sources and compile.');
+        const queued = this.queue(project).enqueue(
+            'run',
+            card.path,
+            async signal => (await this.solveCards(project, [card.key], signal, solveOnly)).get(card.key),
+            { cardKey: card.key });
+        const results = await queued.result;
+        return results && results.length > 0 ? results : undefined;
     }
-}
\ No newline at end of file
+
+    /**
+     * Runs a logic program for many cards at once. All the cards are calculated with one solve,
+     * and the results are grouped by card.
+     *
+     * @param {string} projectPath Path to a project
+     * @param {calculationTarget} target Cards to calculate: either a list of card keys,
+     *                                   a card and its descendants ({ subtree: cardKey }), or 'all' cards.
+     * @param {boolean} solveOnly Optional, use only the program grounded with 'ground()'; fails, if it is outdated.
+     * @returns parsed program output of each card; cards without calculated fields are not included.
+     */
+    public async runBatch(projectPath: string, target: calculationTarget, solveOnly: boolean = false): Promise<{ [cardKey: string]: calculatedField[] }> {
+        return this.batch(new Project(projectPath), target, solveOnly);
+    }
+}
@@ -22,11 +22,15 @@ const invalidNames = new RegExp('[<>:"/\\|?*\x00-\x1F]|^(?:aux|con|clock$|nul|pr
 
 // Generic options interface
 export interface CardsOptions {
+    all?: boolean,
     details?: boolean,
     format?: string,
+    groundOnly?: boolean,
     output?: string,
+    profile?: boolean,
     projectPath?: string,
     repeat?: number,
+    solveOnly?: boolean,
 }
 
 export enum Cmd {
@@ -187,6 +191,18 @@ export class Commands {
         return contentValidated && lengthValidated;
     }
 
+    // Checks if command changes the project (or generates the logic program); project snapshot
+    // is stored only after such commands, so that reading commands do not write to the project.
+    private static changesProject(command: Cmd, args: string[]): boolean {
+        if (command === Cmd.calc) {
+            return args[0] === 'generate';
+        }
+        if (command === Cmd.create) {
+            return args[0] !== 'project';
+        }
+        return [Cmd.add, Cmd.edit, Cmd.import, Cmd.move, Cmd.remove, Cmd.rename, Cmd.transition].includes(command);
+    }
+
     /**
      * Executes one command for CLI.
      *
@@ -196,6 +212,20 @@ export class Commands {
      * @returns request status; 200 if success; 400 in handled error; 500 in unknown error
      */
     public async command(command: Cmd, args: string[], options: CardsOptions): Promise<requestStatus> {
+        const changesProject = Commands.changesProject(command, args);
+        const status = await this.executeCommand(command, args, options);
+        if (changesProject && status.statusCode === 200) {
+            try {
+                await new Project(this.projectPath).saveSnapshot();
+            } catch {
+                // Snapshot is only a cache; the command itself succeeded.
+            }
+        }
+        return status;
+    }
+
+    // Executes one command.
+    private async executeCommand(command: Cmd, args: string[], options: CardsOptions): Promise<requestStatus> {
         this.projectPath = '';
         // Set project path and validate it.
         const creatingNewProject = command === Cmd.create && args[0] === 'project';
@@ -349,9 +379,11 @@ export class Commands {
      * @param command Specific calculate command to execute. Supported values: generate, run
      * @param options Options for the command. See below.
      * @param cardKey Optional, parent cardKey, if any. If omitted, the calculations will be done for the whole card-tree.
-     * @details Options can contain two command specific options:
-     *          grounding - (description omitted)
-     *          solving - (description omitted)
+     * @details Options can contain command specific options:
+     *          all - "run" calculates all cards of the project in one pass
+     *          groundOnly - "run" only grounds the logic program and stores it for later runs
+     *          profile - "run" returns solver statistics of the card's calculation, per module
+     *          solveOnly - "run" uses the stored grounded program; fails, if it is missing or outdated
      * @returns {requestStatus}
      *       statusCode 200 when operation succeeded
      *  <br> statusCode 400 when input validation failed
@@ -361,13 +393,36 @@ export class Commands {
             this.calcCmd.generate(options?.projectPath || '', cardKey);
             return { statusCode: 200 };
         } else if (command === 'run') {
-            if (!cardKey) {
+            if (options.groundOnly && (options.solveOnly || options.all || cardKey)) {
+                return { statusCode: 400, message: `"${command} --ground-only" does not accept cardkey, "--all" or "--solve-only"` };
+            }
+            if (options.profile && (options.all || options.groundOnly || options.solveOnly)) {
+                return { statusCode: 400, message: `"${command} --profile" does not accept "--all", "--ground-only" or "--solve-only"` };
+            }
+            if (options.all && cardKey) {
+                return { statusCode: 400, message: `"${command} --all" does not accept cardkey` };
+            }
+            if (!options.groundOnly && !options.all && !cardKey) {
                 return { statusCode: 400, message: `"${command}" requires cardkey` };
             }
-            return {
-                statusCode: 200,
-                payload: await this.calcCmd.run(options?.projectPath || '', cardKey)
-            };
+            try {
+                if (options.groundOnly) {
+                    await this.calcCmd.ground(options?.projectPath || '');
+                    return { statusCode: 200 };
+                }
+                if (options.profile) {
+                    return { statusCode: 200, payload: await this.calcCmd.profile(options?.projectPath || '', cardKey!) };
+                }
+                return {
+                    statusCode: 200,
+                    payload: options.all
+                        ? await this.calcCmd.runBatch(options?.projectPath || '', 'all', options.solveOnly)
+                        : await this.calcCmd.run(options?.projectPath || '', cardKey!, options.solveOnly)
+                };
+            } catch (error) {
+                // E.g. card was not found, or grounded program is missing or outdated.
+                return { statusCode: 400, message: errorFunction(error) };
+            }
         }
         return { statusCode: 400, message: `Invalid command for calculation ${command}` };
     }
@@ -1,13 +1,15 @@
 // node
-import { basename, join, sep } from 'node:path';
+import { join, sep } from 'node:path';
 import { readdir, readFile, writeFile } from 'node:fs/promises';
 
 // ismo
+import { CardIndex } from './card-index.js';
 import { formatJson } from '../utils/json.js';
-import { getFilesSync, pathExists } from '../utils/file-utils.js';
+import { IOScheduler, ioPriority } from '../utils/io-scheduler.js';
+import { ProjectSnapshot } from './project-snapshot.js';
 
 // interfaces
-import { attachmentDetails, card, cardNameRegEx, fetchCardDetails } from '../interfaces/project-interfaces.js';
+import { attachmentDetails, card, cardMetadata, cardNameRegEx, fetchCardDetails } from '../interfaces/project-interfaces.js';
 
 // asciidoctor
 import asciidoctor from '@asciidoctor/core';
@@ -25,6 +27,8 @@ export class CardContainer {
     static cardContentFile = 'index.adoc';
     static schemaContentFile = '.schema';
 
+    static maxCardsReadAhead = 32;
+
     constructor(path: string, name: string) {
         this.basePath = path;
         this.containerName = name;
@@ -40,205 +44,186 @@ export class CardContainer {
         }
     }
 
-    // Lists all direct children.
-    private async childrenCards(cardPath: string, details?: fetchCardDetails) {
-        const containerCards: card[] = [];
-        await this.doCollectCards(cardPath, containerCards, details, true);
-        return containerCards;
-    }
-
-    // Gets conditionally content
-    private async getContent(currentPath: string, include?: boolean): Promise<string | attachmentDetails[] | card[]> {
-        return include ? await readFile(join(currentPath, CardContainer.cardContentFile), { encoding: 'utf-8' }) : '';
-    }
-
-    // Gets conditionally metadata
-    private async getMetadata(currentPath: string, include?: boolean): Promise<string | attachmentDetails[] | card[]> {
-        return include ? await readFile(join(currentPath, CardContainer.cardMetadataFile), { encoding: 'utf-8' }) : '';
-    }
-
-    // Gets conditionally attachments
-    private async getAttachments(currentPath: string, files: attachmentDetails[], include?: boolean): Promise<string | attachmentDetails[] | card[]> {
-        return include ? await this.doCollectAttachments(currentPath, files) : [];
+    // Lists card folders of a container folder as cards without details.
+    private async cardFolders(folder: string, priority: ioPriority = 'background'): Promise<card[]> {
+        const entries = await this.folderEntries(folder, priority);
+        return entries
+            .filter(entry => entry.isDirectory() && cardNameRegEx.test(entry.name))
+            .map(entry => ({ key: entry.name, path: join(folder, entry.name) }));
     }
 
-    // Gets conditionally children
-    private async getChildren(currentPath: string, details: fetchCardDetails = {}): Promise<string | attachmentDetails[] | card[]> {
-        return details.children ? await this.childrenCards(currentPath, details) : [];
+    // Loads details of cards; if 'recursive' is set, loads also all their descendants to 'children'.
+    // Cards are loaded level by level; I/O scheduler limits the number of concurrent reads.
+    private async doLoadCards(cards: card[], details: fetchCardDetails = {}, recursive: boolean = false, priority: ioPriority = 'background'): Promise<card[]> {
+        // optimization: do not create AsciiDoctor Processor, unless it is needed.
+        const asciiDocProcessor = (details.contentType && details.contentType === 'html')
+            ? asciidoctor()
+            : undefined;
+
+        let level = cards;
+        while (level.length > 0) {
+            const children = await Promise.all(level.map(card =>
+                this.doReadCard(card, details, recursive, priority, asciiDocProcessor)));
+            level = children.flat();
+        }
+        return cards;
     }
 
-    // Find specific card
-    // todo: combine doFind & doCollect
-    private async doFindCard(path: string, cardKey: string, details: fetchCardDetails = {}, foundCards: card[]): Promise<card[]> {
-        const entries = await readdir(path, { withFileTypes: true });
-        if (foundCards.length > 0) {
-            return foundCards;
+    // Reads details of one card. If 'listChildren' is set, card's children are added to the card
+    // without details, and returned so that they can be loaded.
+    private async doReadCard(card: card, details: fetchCardDetails, listChildren: boolean, priority: ioPriority, asciiDocProcessor?: ReturnType<typeof asciidoctor>): Promise<card[]> {
+        const scheduler = IOScheduler.getInstance();
+        const [cardContent, cardMetadata, cardAttachments, cardChildren] = await Promise.all([
+            details.content
+                ? scheduler.schedule(() => readFile(join(card.path, CardContainer.cardContentFile), { encoding: 'utf-8' }), priority)
+                : '',
+            details.metadata ? this.readMetadata(card, priority) : undefined,
+            details.attachments ? this.readAttachments(card, priority) : [],
+            listChildren ? this.cardFolders(join(card.path, 'c'), priority) : []
+        ]);
+
+        if (details.content) {
+            card.content = asciiDocProcessor
+                ? asciiDocProcessor.convert(cardContent) as string
+                : cardContent;
         }
-
-        let asciiDocProcessor;
-        // optimization: do not create AsciiDoctor Processor, unless it is needed.
-        if (details.contentType && details.contentType === 'html') {
-            asciiDocProcessor = asciidoctor();
+        if (details.metadata) {
+            card.metadata = cardMetadata;
         }
-
-        for (const entry of entries) {
-            if (entry.isDirectory()) {
-                const currentPath = join(entry.path, entry.name);
-                if (cardNameRegEx.test(entry.name)) {
-                    // todo: from hereon, this could be shared with doCollect
-                    if (entry.name === cardKey) {
-                        const attachmentFiles: attachmentDetails[] = [];
-                        const promiseContainer = [
-                            this.getContent(currentPath, details.content),
-                            this.getMetadata(currentPath, details.metadata),
-                            this.getChildren(currentPath, details),
-                            this.getAttachments(currentPath, attachmentFiles, details.attachments)
-                        ];
-                        const [cardContent, cardMetadata, cardChildren] = await Promise.all(promiseContainer);
-
-                        const content = (details.contentType && details.contentType === 'html')
-                            ? asciiDocProcessor?.convert(cardContent as string)
-                            : cardContent;
-
-                        foundCards.push({
-                            key: entry.name,
-                            path: currentPath,
-                            ...(details.content) && { content: content as string },
-                            ...(details.metadata) && { metadata: JSON.parse(cardMetadata as string) },
-                            ...(details.parent) && { parent: this.parentCard(currentPath) },
-                            ...(details.children) && { children: cardChildren as card[] },
-                            ...(details.calculations) && { calculations: [] },
-                            ...(details.attachments) && { attachments: [...attachmentFiles] }
-                        });
-                        break; //optimization - there can only be one.
-                    }
-                }
-                await this.doFindCard(currentPath, cardKey, details, foundCards);
-            }
+        if (details.parent) {
+            card.parent = this.parentCard(card.path);
         }
-        return foundCards;
-    }
-
-    // Collects all attachments from container.
-    // Function collects attachments from one folder and recurses to valid, potential folders.
-    private async doCollectAttachments(folder: string, attachments: attachmentDetails[]): Promise<attachmentDetails[]> {
-        const currentPaths: string[] = [];
-        if (pathExists(folder)) {
-            const entries = (await readdir(folder, { withFileTypes: true })).filter(item => item.isDirectory());
-            for (const entry of entries) {
-                if (cardNameRegEx.test(entry.name) || (entry.name === 'c')) {
-                    currentPaths.push(join(entry.path, entry.name));
-                } else {
-                    // Set paths.
-                    const attachmentFolder = join(entry.path, entry.name);
-                    const childrenFolder = join(entry.path, 'c');
-                    const cardItem = basename(entry.path) || '';
-
-                    // Collect all attachments.
-                    const entryAttachments = await readdir(attachmentFolder, { withFileTypes: true });
-                    entryAttachments.forEach(
-                        async attachment => attachments.push({
-                            card: cardItem,
-                            fileName: attachment.name,
-                            path: attachment.path
-                        })
-                    );
-                    if (pathExists(childrenFolder)) {
-                        currentPaths.push(childrenFolder);
-                    }
-                }
-            }
+        if (details.attachments) {
+            card.attachments = cardAttachments;
+        }
+        if (details.calculations) {
+            // Container does not calculate; project replaces these with the calculated fields.
+            card.calculations = [];
         }
-        if (currentPaths) {
-            const promises = currentPaths.map(item => this.doCollectAttachments(item, attachments));
-            await Promise.all(promises);
-            return attachments;
+        if (listChildren) {
+            card.children = cardChildren;
         }
-        return attachments;
+        return cardChildren;
     }
 
-    // Collects all cards from container.
-    private async doCollectCards(path: string, cards: card[], details: fetchCardDetails = {}, directChildrenOnly: boolean = false): Promise<card[]> {
-        const entries = await readdir(path, { withFileTypes: true });
-        let finish = false;
-        const currentPaths: string[] = [];
-
-        for (const entry of entries) {
-            if (entry.isDirectory()) {
-                const currentPath = join(entry.path, entry.name);
-                currentPaths.push(currentPath);
-                if (cardNameRegEx.test(entry.name)) {
-
-                    if (directChildrenOnly) {
-                        // Make recursion stop on the level where first children cards are found.
-                        finish = true;
-                    }
-
-                    const attachmentFiles: attachmentDetails[] = [];
-                    const promiseContainer = [
-                        this.getContent(currentPath, details.content),
-                        this.getMetadata(currentPath, details.metadata),
-                        this.getChildren(currentPath, details),
-                        this.getAttachments(currentPath, attachmentFiles, details.attachments)
-                    ];
-                    const [cardContent, cardMetadata, cardChildren] = await Promise.all(promiseContainer);
-
-                    cards.push({
-                        key: entry.name,
-                        path: currentPath,
-                        ...(details.content) && { content: cardContent as string },
-                        ...(details.metadata) && { metadata: JSON.parse(cardMetadata as string) },
-                        ...(details.parent) && { parent: this.parentCard(currentPath) },
-                        ...(details.children) && { children: cardChildren as card[] },
-                        ...(details.attachments) && { attachments: [...attachmentFiles] }
-                    });
-                }
-            }
+    // Lists folder entries; missing folder does not have entries.
+    private async folderEntries(folder: string, priority: ioPriority) {
+        try {
+            return await IOScheduler.getInstance().schedule(() => readdir(folder, { withFileTypes: true }), priority);
+        } catch {
+            return [];
         }
+    }
 
-        // Continue collecting cards from children
-        if (!finish && currentPaths) {
-            const promises = currentPaths.map(item => this.doCollectCards(item, cards, details, directChildrenOnly));
-            await Promise.all(promises);
+    // Lists attachments of a card.
+    private async readAttachments(card: card, priority: ioPriority): Promise<attachmentDetails[]> {
+        const attachmentFolder = join(card.path, 'a');
+        return (await this.folderEntries(attachmentFolder, priority)).map(attachment => ({
+            card: card.key,
+            fileName: attachment.name,
+            path: attachmentFolder
+        }));
+    }
+
+    // Reads metadata of a card; unchanged metadata is returned from the project snapshot.
+    private async readMetadata(card: card, priority: ioPriority): Promise<cardMetadata> {
+        const metadataFile = join(card.path, CardContainer.cardMetadataFile);
+        const snapshot = ProjectSnapshot.owning(metadataFile);
+        if (snapshot) {
+            return snapshot.cardMetadata(metadataFile, priority);
         }
-        return cards;
+        return JSON.parse(await IOScheduler.getInstance().schedule(() => readFile(metadataFile, { encoding: 'utf-8' }), priority));
     }
 
     // Lists all attachments from container.
     protected async attachments(path: string): Promise<attachmentDetails[]> {
-        const attachments: attachmentDetails[] = [];
-        const cards: card[] = [];
-        await this.doCollectCards(path, cards, { attachments: true });
+        const cards = await this.cards(path, { attachments: true });
+        return cards.flatMap(card => card.attachments || []);
+    }
+
+    // Iterates cards of a container folder and their descendants.
+    protected async *iterateCardTree(path: string, details: fetchCardDetails = {}): AsyncGenerator<card> {
+        yield* this.iterateCardsFrom(await this.cardFolders(path), details);
+    }
 
-        cards.forEach((card) => {
-            if (card.attachments) {
-                attachments.push(...card.attachments.flat());
+    // Iterates cards and their descendants. Cards are yielded without children, as soon as they
+    // have been read. At most 'maxCardsReadAhead' cards are read ahead of the consumer.
+    protected async *iterateCardsFrom(cards: card[], details: fetchCardDetails = {}): AsyncGenerator<card> {
+        // optimization: do not create AsciiDoctor Processor, unless it is needed.
+        const asciiDocProcessor = (details.contentType && details.contentType === 'html')
+            ? asciidoctor()
+            : undefined;
+
+        // Cards that have not been read yet. Taken cards are released, so that cards are not kept
+        // in memory after they have been yielded.
+        const queue: (card | undefined)[] = [...cards];
+        const reading: Promise<card>[] = [];
+        let next = 0;
+
+        const read = async (card: card) => {
+            queue.push(...await this.doReadCard(card, details, true, 'background', asciiDocProcessor));
+            delete card.children;
+            return card;
+        };
+
+        while (next < queue.length || reading.length > 0) {
+            while (next < queue.length && reading.length < CardContainer.maxCardsReadAhead) {
+                const card = queue[next] as card;
+                queue[next++] = undefined;
+                if (next > CardContainer.maxCardsReadAhead && next * 2 > queue.length) {
+                    queue.splice(0, next);
+                    next = 0;
+                }
+                const promise = read(card);
+                // Errors are thrown when the card is yielded.
+                promise.catch(() => {});
+                reading.push(promise);
             }
-        });
+            yield await (reading.shift() as Promise<card>);
+        }
+    }
 
-        return attachments;
+    // Reads cards of a container folder to memory as a card tree in one pass.
+    protected async readCardTree(path: string, details: fetchCardDetails = {}): Promise<card[]> {
+        return this.doLoadCards(await this.cardFolders(path), details, true);
     }
 
     // Lists all cards from container.
-    protected async cards(path: string, details: fetchCardDetails = {}, directChildrenOnly: boolean = false): Promise<card[]> {
-        const containerCards: card[] = [];
-        await this.doCollectCards(path, containerCards, details, directChildrenOnly);
-        return containerCards;
+    protected async cards(path: string, details: fetchCardDetails = {}): Promise<card[]> {
+        const cards: card[] = [];
+        const flatten = (items: card[]) => {
+            for (const item of items) {
+                cards.push(item);
+                flatten(item.children || []);
+            }
+        };
+        flatten(await this.readCardTree(path, details));
+        // Children are always collected; they are returned only if requested.
+        if (!details.children) {
+            cards.forEach(item => delete item.children);
+        }
+        return cards;
     }
 
     // Finds a specific card.
     protected async findCard(path: string, cardKey: string, details: fetchCardDetails = {}): Promise<card | undefined> {
-        const foundCards: card[] = [];
-        await this.doFindCard(path, cardKey, details, foundCards);
-        return foundCards.at(0);
+        const entry = await this.containerIndex(path).find(cardKey);
+        if (!entry || entry.key === CardIndex.rootKey) {
+            return undefined;
+        }
+        const cards = await this.doLoadCards([{ key: cardKey, path: entry.path }], details, details.children === true, 'interactive');
+        return cards.at(0);
+    }
+
+    // Returns index of cards in container.
+    protected containerIndex(path: string): CardIndex {
+        return CardIndex.getInstance(path);
     }
 
     // Checks if container has the specified card.
-    protected hasCard(cardKey: string, path: string): boolean {
-        const allFiles = getFilesSync(path);
-        const cardIndexJsonFile = join(cardKey, CardContainer.cardMetadataFile);
-        const found = allFiles.findIndex(file => file.includes(cardIndexJsonFile));
-        return (found !== -1);
+    protected async hasCard(cardKey: string, path: string): Promise<boolean> {
+        const entry = await this.containerIndex(path).find(cardKey);
+        return entry !== undefined && entry.key !== CardIndex.rootKey;
     }
 
     // Persists card content.
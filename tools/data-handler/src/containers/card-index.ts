@@ -0,0 +1,513 @@
+// node
+import { basename, dirname, join, relative, sep } from 'node:path';
+import { readdir, stat } from 'node:fs/promises';
+
+// ismo
+import { cardIndexEntry, cardIndexState, cardNameRegEx } from '../interfaces/project-interfaces.js';
+import { IOScheduler, ioPriority } from '../utils/io-scheduler.js';
+import { ProjectSnapshot } from './project-snapshot.js';
+
+/**
+ * Index of cards in one card container folder (project's 'cardroot', or template's 'c' folder).
+ * Maps card keys to card folders and maintains parent-child relations, so that a card can be
+ * found without walking the card tree. The index is built once and kept current either by
+ * the commands that change the card tree, or by comparing directory modification times.
+ * Index state is stored to the project snapshot, so that it does not need to be re-built
+ * when a new process starts; only the folders that have changed are re-read.
+ * Building and rescanning the index are background work; only the check that a looked up
+ * card still exists has interactive priority.
+ */
+export class CardIndex {
+
+    private static instances: Map<string, CardIndex> = new Map();
+
+    private building?: Promise<void>;
+    private built: boolean = false;
+    private entries: Map<string, cardIndexEntry> = new Map();
+    private misses: Map<string, number> = new Map();
+    private refreshing?: Promise<void>;
+    private rootEntry: cardIndexEntry;
+    private rootPath: string;
+    private stamps: Map<string, number> = new Map();
+
+    // Lookups of a missing card re-check the index at most this often; number of remembered missing cards.
+    static missIntervalMs = 1000;
+    static maxMisses = 1000;
+    static rootKey = 'root';
+
+    constructor(path: string) {
+        this.rootPath = path;
+        this.rootEntry = { key: CardIndex.rootKey, path: path, parent: '', children: [] };
+    }
+
+    // Adds card to the index and to its parent's children.
+    private addEntry(key: string, path: string, parentKey: string) {
+        const parent = this.entry(parentKey);
+        if (!parent) {
+            return;
+        }
+        this.entries.set(key, { key: key, path: path, parent: parentKey, children: [] });
+        this.misses.delete(key);
+        if (!parent.children.includes(key)) {
+            parent.children.push(key);
+        }
+    }
+
+    // Builds the index; from the project snapshot if there is one, otherwise from scratch.
+    private async build() {
+        const state = await this.snapshot?.cardIndexState(this.rootPath);
+        if (state) {
+            this.restore(state);
+            await this.refresh();
+        } else {
+            this.clear();
+            await this.scanContainer(this.rootPath, CardIndex.rootKey);
+        }
+        this.built = true;
+        this.changed();
+    }
+
+    // Informs project snapshot that the index has changed.
+    private changed() {
+        this.snapshot?.indexChanged(this.rootPath, () => this.built ? this.state() : undefined);
+    }
+
+    // Empties the index.
+    private clear() {
+        this.entries.clear();
+        this.stamps.clear();
+        this.misses.clear();
+        this.rootEntry.children = [];
+    }
+
+    // Returns index entry of a card, or the root entry.
+    private entry(key: string): cardIndexEntry | undefined {
+        return key === CardIndex.rootKey ? this.rootEntry : this.entries.get(key);
+    }
+
+    // Checks if folder is a card container folder (root, or 'c' folder of a card).
+    private isContainerFolder(path: string): boolean {
+        return path === this.rootPath || basename(path) === 'c';
+    }
+
+    // Returns modification time of a folder, or undefined if the folder does not exist.
+    private async modificationTime(path: string, priority: ioPriority = 'background'): Promise<number | undefined> {
+        try {
+            return (await IOScheduler.getInstance().schedule(() => stat(path), priority)).mtimeMs;
+        } catch {
+            return undefined;
+        }
+    }
+
+    // Checks all known folders against their modification times and re-reads the changed ones.
+    private async refresh() {
+        const changedFolders: string[] = [];
+        await Promise.all([...this.stamps].map(async ([folder, stamp]) => {
+            if (await this.modificationTime(folder) !== stamp) {
+                changedFolders.push(folder);
+            }
+        }));
+
+        // Handle folders closest to root first; their re-read might remove deeper folders.
+        changedFolders.sort((a, b) => a.length - b.length);
+        for (const folder of changedFolders) {
+            if (this.stamps.has(folder)) {
+                await this.rescanFolder(folder);
+            }
+        }
+        if (changedFolders.length > 0) {
+            this.misses.clear();
+            this.changed();
+        }
+    }
+
+    // Refreshes the index after a failed lookup. Concurrent lookups share the refresh. A card that
+    // was not found is not looked for again for 'missIntervalMs', unless the index changes in between;
+    // without this, repeated lookups of a missing card would check every folder of the tree each time.
+    private async refreshAfterMiss(key: string) {
+        const missed = this.misses.get(key);
+        if (missed !== undefined && Date.now() - missed < CardIndex.missIntervalMs) {
+            return;
+        }
+        if (!this.refreshing) {
+            this.refreshing = this.refresh().finally(() => {
+                this.refreshing = undefined;
+            });
+        }
+        await this.refreshing;
+        if (!this.entries.has(key)) {
+            if (this.misses.size >= CardIndex.maxMisses) {
+                this.misses.clear();
+            }
+            this.misses.set(key, Date.now());
+        }
+    }
+
+    // Removes card and its children from the index.
+    private removeEntry(key: string) {
+        const entry = this.entries.get(key);
+        if (!entry) {
+            return;
+        }
+        for (const child of [...entry.children]) {
+            this.removeEntry(child);
+        }
+        const parent = this.entry(entry.parent);
+        if (parent) {
+            parent.children = parent.children.filter(item => item !== key);
+        }
+        this.stamps.delete(entry.path);
+        this.stamps.delete(join(entry.path, 'c'));
+        this.entries.delete(key);
+    }
+
+    // Re-reads one container folder and updates the cards that were added or removed from it.
+    private async rescanContainer(folder: string, parentKey: string) {
+        const parent = this.entry(parentKey);
+        if (!parent) {
+            return;
+        }
+        const cardFolders = await this.scanFolder(folder);
+        const found = cardFolders.map(item => item.name);
+
+        for (const child of [...parent.children]) {
+            if (!found.includes(child)) {
+                this.forget(child);
+                this.removeEntry(child);
+            }
+        }
+        await Promise.all(cardFolders.map(async item => {
+            const cardPath = join(folder, item.name);
+            const existing = this.entries.get(item.name);
+            if (existing && existing.path === cardPath) {
+                return;
+            }
+            if (existing) {
+                this.removeEntry(item.name);
+            }
+            this.addEntry(item.name, cardPath, parentKey);
+            await this.scanCard(cardPath, item.name);
+        }));
+    }
+
+    // Re-reads a changed folder.
+    private async rescanFolder(folder: string) {
+        if (this.isContainerFolder(folder)) {
+            const parentKey = folder === this.rootPath ? CardIndex.rootKey : basename(dirname(folder));
+            await this.rescanContainer(folder, parentKey);
+            return;
+        }
+        const key = basename(folder);
+        const stamp = await this.modificationTime(folder);
+        if (stamp === undefined) {
+            this.forget(key);
+            this.removeEntry(key);
+            return;
+        }
+        this.stamps.set(folder, stamp);
+        await this.rescanContainer(join(folder, 'c'), key);
+    }
+
+    // Sets index content from a stored state.
+    private restore(state: cardIndexState) {
+        this.clear();
+        for (const card of state.cards) {
+            this.addEntry(card.key, join(this.rootPath, card.path), card.parent);
+        }
+        for (const [folder, stamp] of Object.entries(state.stamps)) {
+            this.stamps.set(join(this.rootPath, folder), stamp);
+        }
+    }
+
+    // Updates modification time of a folder after the index has been updated.
+    private async restamp(folder: string) {
+        const stamp = await this.modificationTime(folder);
+        if (stamp !== undefined) {
+            this.stamps.set(folder, stamp);
+        } else {
+            this.stamps.delete(folder);
+        }
+    }
+
+    // Returns snapshot of the project that contains the indexed folder.
+    private get snapshot(): ProjectSnapshot | undefined {
+        return ProjectSnapshot.owning(this.rootPath);
+    }
+
+    // Removes stored items of a card from the project snapshot.
+    private forget(key: string) {
+        const entry = this.entries.get(key);
+        if (entry) {
+            this.snapshot?.forget(entry.path);
+        }
+    }
+
+    // Reads one card folder; its children are in the 'c' subfolder.
+    private async scanCard(cardPath: string, key: string) {
+        await Promise.all([
+            this.restamp(cardPath),
+            this.scanContainer(join(cardPath, 'c'), key)
+        ]);
+    }
+
+    // Reads all cards from a container folder (and recursively from their children).
+    private async scanContainer(folder: string, parentKey: string) {
+        const cardFolders = await this.scanFolder(folder);
+        await Promise.all(cardFolders.map(async item => {
+            const cardPath = join(folder, item.name);
+            this.addEntry(item.name, cardPath, parentKey);
+            await this.scanCard(cardPath, item.name);
+        }));
+    }
+
+    // Lists card folders of a container folder and stamps the folder.
+    private async scanFolder(folder: string) {
+        try {
+            const [entries, stamp] = await Promise.all([
+                IOScheduler.getInstance().schedule(() => readdir(folder, { withFileTypes: true }), 'background'),
+                this.modificationTime(folder)
+            ]);
+            if (stamp !== undefined) {
+                this.stamps.set(folder, stamp);
+            }
+            return entries.filter(entry => entry.isDirectory() && cardNameRegEx.test(entry.name));
+        } catch {
+            // Folder does not exist; cards without children do not have 'c' folder.
+            this.stamps.delete(folder);
+            return [];
+        }
+    }
+
+    /**
+     * Adds a card to the index. If the index has not been built yet, nothing is done,
+     * since the card will be found when the index is built.
+     * @param {string} key card key
+     * @param {string} path path to the card folder
+     * @param {string} parentKey parent card key, or 'root' for top level cards.
+     */
+    public async add(key: string, path: string, parentKey: string = CardIndex.rootKey) {
+        if (!this.built) {
+            return;
+        }
+        this.addEntry(key, path, parentKey);
+        const parent = this.entry(parentKey);
+        await Promise.all([
+            this.restamp(path),
+            this.restamp(dirname(path)),
+            (parent && parent !== this.rootEntry) ? this.restamp(parent.path) : Promise.resolve()
+        ]);
+        this.changed();
+    }
+
+    /**
+     * Returns card keys of the direct children of a card.
+     * @param {string} key card key, or 'root' for top level cards.
+     * @returns card keys of the children, or undefined if card is not in the index.
+     */
+    public async children(key: string): Promise<string[] | undefined> {
+        const entry = await this.find(key);
+        return entry ? [...entry.children] : undefined;
+    }
+
+    /**
+     * Finds a card from the index. If card's folder has been removed, its container folder
+     * is re-read. If card is still not found, changed folders are re-read before giving up;
+     * for the same missing card, this is done at most once in 'missIntervalMs'.
+     * @param {string} key card key
+     * @param {boolean} refresh Optional; if false, index is not updated when card is not found.
+     * @returns index entry of a card, or undefined if card is not in the container.
+     */
+    public async find(key: string, refresh: boolean = true): Promise<cardIndexEntry | undefined> {
+        await this.update();
+        if (key === CardIndex.rootKey) {
+            return this.rootEntry;
+        }
+        const entry = this.entries.get(key);
+        if (entry && await this.modificationTime(entry.path, 'interactive') !== undefined) {
+            return entry;
+        }
+        if (!refresh) {
+            return undefined;
+        }
+        if (entry) {
+            await this.rescanFolder(dirname(entry.path));
+            this.changed();
+        }
+        await this.refreshAfterMiss(key);
+        return this.entries.get(key);
+    }
+
+    /**
+     * Returns index instance of a container folder. Instances are shared, so that all
+     * Project objects using the same folder share the index.
+     * @param {string} path path to card container folder.
+     * @returns index of the folder.
+     */
+    public static getInstance(path: string): CardIndex {
+        let instance = CardIndex.instances.get(path);
+        if (!instance) {
+            instance = new CardIndex(path);
+            CardIndex.instances.set(path, instance);
+        }
+        return instance;
+    }
+
+    /**
+     * Marks the index outdated. Index is re-built on next use.
+     */
+    public invalidate() {
+        this.built = false;
+        this.building = undefined;
+    }
+
+    /**
+     * Removes shared index instances of all container folders that are within 'path'.
+     * @param {string} path folder path
+     */
+    public static invalidateFolder(path: string) {
+        for (const [folder, instance] of CardIndex.instances) {
+            if (folder === path || folder.startsWith(path + sep)) {
+                instance.invalidate();
+                CardIndex.instances.delete(folder);
+            }
+        }
+    }
+
+    /**
+     * Returns keys of cards in the index; each card is followed by its descendants.
+     * @param {string} cardKey Optional, if given returns only the card and its descendants.
+     * @returns card keys; empty if 'cardKey' is not in the index.
+     */
+    public async keys(cardKey?: string): Promise<string[]> {
+        await this.update();
+        const keys: string[] = [];
+        const collect = (entry: cardIndexEntry) => {
+            for (const child of entry.children) {
+                const childEntry = this.entries.get(child);
+                if (childEntry) {
+                    keys.push(child);
+                    collect(childEntry);
+                }
+            }
+        };
+        if (cardKey === undefined) {
+            collect(this.rootEntry);
+            return keys;
+        }
+        const entry = this.entries.get(cardKey);
+        if (entry) {
+            keys.push(cardKey);
+            collect(entry);
+        }
+        return keys;
+    }
+
+    /**
+     * Moves a card (and its children) to a new location in the index.
+     * @param {string} key card key
+     * @param {string} path new path to the card folder
+     * @param {string} parentKey new parent card key, or 'root'.
+     */
+    public async move(key: string, path: string, parentKey: string = CardIndex.rootKey) {
+        if (!this.built) {
+            return;
+        }
+        const previous = this.entries.get(key);
+        this.forget(key);
+        this.removeEntry(key);
+        await this.add(key, path, parentKey);
+        await this.scanContainer(join(path, 'c'), key);
+        if (previous) {
+            const previousParent = this.entry(previous.parent);
+            await Promise.all([
+                this.restamp(dirname(previous.path)),
+                (previousParent && previousParent !== this.rootEntry) ? this.restamp(previousParent.path) : Promise.resolve()
+            ]);
+        }
+        this.changed();
+    }
+
+    /**
+     * Returns the index that contains a given card path.
+     * @param {string} path path to a card
+     * @returns index that has the card's container folder as root, or undefined.
+     */
+    public static owning(path: string): CardIndex | undefined {
+        for (const [folder, instance] of CardIndex.instances) {
+            if (path.startsWith(folder + sep)) {
+                return instance;
+            }
+        }
+        return undefined;
+    }
+
+    /**
+     * Removes a card (and its children) from the index.
+     * @param {string} key card key
+     */
+    public async remove(key: string) {
+        if (!this.built) {
+            return;
+        }
+        const entry = this.entries.get(key);
+        if (!entry) {
+            return;
+        }
+        const parent = this.entry(entry.parent);
+        this.forget(key);
+        this.removeEntry(key);
+        await Promise.all([
+            this.restamp(dirname(entry.path)),
+            (parent && parent !== this.rootEntry) ? this.restamp(parent.path) : Promise.resolve()
+        ]);
+        this.changed();
+    }
+
+    /**
+     * Getter. Returns path to the container folder of the index.
+     */
+    public get root(): string {
+        return this.rootPath;
+    }
+
+    /**
+     * Returns state of the index for storing. Cards are listed parents first.
+     * Folders that were modified very recently are stored without modification time,
+     * since a change within the same timestamp granularity could otherwise go unnoticed.
+     * @returns index state; paths are relative to the indexed folder.
+     */
+    public state(): cardIndexState {
+        const cards: cardIndexState['cards'] = [];
+        const queue = [...this.rootEntry.children];
+        for (let index = 0; index < queue.length; index++) {
+            const entry = this.entries.get(queue[index]);
+            if (entry) {
+                cards.push({ key: entry.key, path: relative(this.rootPath, entry.path), parent: entry.parent });
+                queue.push(...entry.children);
+            }
+        }
+        const now = Date.now();
+        const stamps: Record<string, number> = {};
+        for (const [folder, stamp] of this.stamps) {
+            stamps[relative(this.rootPath, folder)] = now - stamp > ProjectSnapshot.racyWindowMs ? stamp : 0;
+        }
+        return { cards: cards, stamps: stamps };
+    }
+
+    /**
+     * Builds the index, if it has not been built yet.
+     */
+    public async update() {
+        if (this.built) {
+            return;
+        }
+        if (!this.building) {
+            this.building = this.build();
+        }
+        const building = this.building;
+        await building;
+        if (this.building === building) {
+            this.building = undefined;
+        }
+    }
+}
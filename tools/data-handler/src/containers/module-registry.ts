@@ -0,0 +1,257 @@
+// node
+import { join, resolve } from 'node:path';
+import { readdir, stat } from 'node:fs/promises';
+
+// ismo
+import { CardContainer } from './card-container.js';
+import { readJsonFile } from '../utils/json.js';
+import { resource } from '../interfaces/project-interfaces.js';
+
+// Types of resources that modules can have.
+export type moduleResourceType = 'calculations' | 'cardtypes' | 'fieldtypes' | 'templates' | 'workflows';
+
+// Resources of one module; resource names are prefixed with module name.
+interface moduleEntry {
+    module: resource
+    prefix?: string
+    resources: Record<moduleResourceType, Map<string, resource>>
+}
+
+/**
+ * Registry of resources in project's imported modules ('.cards/modules').
+ * Modules are read once and resources are indexed by type and name, so that resource
+ * lookups do not need to read the module folders. Registry is updated by the commands that
+ * import and remove modules. Modules are not edited after import, so only the modification
+ * time of the modules folder is checked to notice modules that were added or removed otherwise.
+ */
+export class ModuleRegistry {
+
+    private static instances: Map<string, ModuleRegistry> = new Map();
+
+    private building?: Promise<void>;
+    private entries: Map<string, moduleEntry> = new Map();
+    private modulesFolder: string;
+    private stamp?: number;
+
+    static resourceTypes: moduleResourceType[] = ['calculations', 'cardtypes', 'fieldtypes', 'templates', 'workflows'];
+
+    constructor(modulesFolder: string) {
+        this.modulesFolder = resolve(modulesFolder);
+    }
+
+    // Reads all modules.
+    private async build() {
+        const stamp = await this.modificationTime();
+        const entries: Map<string, moduleEntry> = new Map();
+        if (stamp !== undefined) {
+            const moduleFolders = (await readdir(this.modulesFolder, { withFileTypes: true }))
+                .filter(item => item.isDirectory());
+            const modules = await Promise.all(moduleFolders.map(item => this.readModule(item.name)));
+            modules.forEach(module => entries.set(module.module.name, module));
+        }
+        this.entries = entries;
+        this.stamp = stamp;
+    }
+
+    // Returns modification time of modules folder, or undefined if project has no modules.
+    private async modificationTime(): Promise<number | undefined> {
+        try {
+            return (await stat(this.modulesFolder)).mtimeMs;
+        } catch {
+            return undefined;
+        }
+    }
+
+    // Reads resources of one module.
+    private async readModule(moduleName: string): Promise<moduleEntry> {
+        const entry: moduleEntry = {
+            module: { name: moduleName, path: this.modulesFolder },
+            resources: {
+                calculations: new Map(),
+                cardtypes: new Map(),
+                fieldtypes: new Map(),
+                templates: new Map(),
+                workflows: new Map(),
+            }
+        };
+        const readPrefix = async () => {
+            try {
+                const configuration = await readJsonFile(join(this.modulesFolder, moduleName, CardContainer.projectConfigFileName));
+                entry.prefix = configuration.cardkeyPrefix;
+            } catch {
+                // Module without configuration does not have cards.
+            }
+        };
+        const readResources = ModuleRegistry.resourceTypes.map(async type => {
+            const resourcePath = join(this.modulesFolder, moduleName, type);
+            let files;
+            try {
+                files = await readdir(resourcePath, { withFileTypes: true });
+            } catch {
+                // Module does not have this type of resources.
+                return;
+            }
+            const filteredFiles = (type === 'templates')
+                ? files.filter(item => item.isDirectory())
+                : files.filter(item => item.name !== CardContainer.schemaContentFile);
+            for (const file of filteredFiles) {
+                const name = `${moduleName}/${file.name}`;
+                entry.resources[type].set(name, { name: name, path: resourcePath });
+            }
+        });
+        await Promise.all([readPrefix(), ...readResources]);
+        return entry;
+    }
+
+    // Ensures that registry is current.
+    private async update() {
+        if (this.stamp !== undefined && !this.building && this.stamp === await this.modificationTime()) {
+            return;
+        }
+        if (!this.building) {
+            this.building = this.build();
+        }
+        const building = this.building;
+        try {
+            await building;
+        } finally {
+            if (this.building === building) {
+                this.building = undefined;
+            }
+        }
+    }
+
+    /**
+     * Adds a module to the registry, or re-reads it if it already exists.
+     * @param {string} moduleName name of the module.
+     */
+    public async add(moduleName: string) {
+        await this.update();
+        this.entries.set(moduleName, await this.readModule(moduleName));
+        this.stamp = await this.modificationTime();
+    }
+
+    /**
+     * Finds a resource from modules.
+     * @param {moduleResourceType} type type of resource
+     * @param {string} name name of the resource, including module name (e.g. 'module/resource.json')
+     * @returns resource, or undefined if it does not exist.
+     */
+    public async find(type: moduleResourceType, name: string): Promise<resource | undefined> {
+        await this.update();
+        const found = this.entries.get(name.split('/')[0])?.resources[type].get(name);
+        return found ? { ...found } : undefined;
+    }
+
+    /**
+     * Returns registry of a modules folder. Instances are shared, so that all Project objects
+     * using the same folder share the registry.
+     * @param {string} modulesFolder path to '.cards/modules' folder
+     * @returns registry of the folder.
+     */
+    public static getInstance(modulesFolder: string): ModuleRegistry {
+        const path = resolve(modulesFolder);
+        let instance = ModuleRegistry.instances.get(path);
+        if (!instance) {
+            instance = new ModuleRegistry(path);
+            ModuleRegistry.instances.set(path, instance);
+        }
+        return instance;
+    }
+
+    /**
+     * Marks the registry outdated. Modules are read again on next use.
+     */
+    public invalidate() {
+        this.stamp = undefined;
+    }
+
+    /**
+     * Returns a module.
+     * @param {string} moduleName name of the module
+     * @returns module resource, or undefined if module does not exist.
+     */
+    public async module(moduleName: string): Promise<resource | undefined> {
+        await this.update();
+        const entry = this.entries.get(moduleName);
+        return entry ? { ...entry.module } : undefined;
+    }
+
+    /**
+     * Returns the module that uses a card key prefix.
+     * @param {string} prefix card key prefix
+     * @returns module name, or undefined if no module uses the prefix.
+     */
+    public async moduleByPrefix(prefix: string): Promise<string | undefined> {
+        await this.update();
+        for (const entry of this.entries.values()) {
+            if (entry.prefix === prefix) {
+                return entry.module.name;
+            }
+        }
+        return undefined;
+    }
+
+    /**
+     * Returns resources of a certain type from one module.
+     * @param {string} moduleName name of the module
+     * @param {moduleResourceType} type type of resources
+     * @returns resources; empty if module does not exist.
+     */
+    public async moduleResources(moduleName: string, type: moduleResourceType): Promise<resource[]> {
+        await this.update();
+        return [...this.entries.get(moduleName)?.resources[type].values() ?? []].map(item => ({ ...item }));
+    }
+
+    /**
+     * Returns names of resources in a module.
+     * @param {string} moduleName name of the module
+     * @param {moduleResourceType} type type of resources
+     * @returns resource names; empty if module does not exist.
+     */
+    public async moduleResourceNames(moduleName: string, type: moduleResourceType): Promise<string[]> {
+        await this.update();
+        return [...this.entries.get(moduleName)?.resources[type].keys() ?? []];
+    }
+
+    /**
+     * Returns all modules.
+     * @returns modules; path of each module is the modules folder.
+     */
+    public async modules(): Promise<resource[]> {
+        await this.update();
+        return [...this.entries.values()].map(entry => ({ ...entry.module }));
+    }
+
+    /**
+     * Returns card key prefixes of all modules.
+     * @returns module prefixes.
+     */
+    public async prefixes(): Promise<string[]> {
+        await this.update();
+        return [...this.entries.values()]
+            .map(entry => entry.prefix)
+            .filter(prefix => prefix !== undefined) as string[];
+    }
+
+    /**
+     * Removes a module from the registry.
+     * @param {string} moduleName name of the module.
+     */
+    public async remove(moduleName: string) {
+        await this.update();
+        this.entries.delete(moduleName);
+        this.stamp = await this.modificationTime();
+    }
+
+    /**
+     * Returns resources of a certain type from all modules.
+     * @param {moduleResourceType} type type of resources
+     * @returns resources
+     */
+    public async resources(type: moduleResourceType): Promise<resource[]> {
+        await this.update();
+        return [...this.entries.values()].flatMap(entry =>
+            [...entry.resources[type].values()].map(item => ({ ...item })));
+    }
+}
@@ -0,0 +1,332 @@
+// node
+import { watch } from 'node:fs';
+import { join, resolve, sep } from 'node:path';
+
+// ismo
+import { Calculate } from '../calculate.js';
+import { ClingoEngine } from '../utils/clingo-engine.js';
+import { card, cardNameRegEx, cardtype, fetchCardDetails, fieldtype, project, resource, workflowMetadata } from '../interfaces/project-interfaces.js';
+import { ModuleRegistry } from './module-registry.js';
+import { Project } from './project.js';
+
+// Watched areas of a project.
+type watchedArea = 'cardroot' | '.cards';
+
+/**
+ * Long-lived project for processes that serve many requests, such as the app server.
+ * Project object and the results read from it (cards, resources, cardtypes) are cached.
+ * Cards and resources are watched for changes, and only the affected cache entries
+ * are removed when something changes. If the file system cannot be watched,
+ * nothing is cached.
+ * Returned objects are shared between callers and must not be modified.
+ */
+export class ProjectSession {
+
+    private static instances: Map<string, ProjectSession> = new Map();
+
+    private cache: Map<string, Promise<unknown>> = new Map();
+    private projectObject?: Project;
+    private projectPath: string;
+    private watchers: ReturnType<typeof watch>[] = [];
+
+    constructor(projectPath: string) {
+        this.projectPath = resolve(projectPath);
+        // Session serves many queries; keep the logic program loaded in solver workers.
+        ClingoEngine.persistent = true;
+        this.startWatching();
+    }
+
+    // Returns cached value of 'key'; if there is none, value is read and cached.
+    // Failed reads are not cached.
+    private cached<T>(key: string, read: () => Promise<T>): Promise<T> {
+        if (!this.watching) {
+            return read();
+        }
+        let value = this.cache.get(key) as Promise<T> | undefined;
+        if (!value) {
+            const reading = read();
+            value = reading;
+            this.cache.set(key, reading);
+            reading.catch(() => {
+                if (this.cache.get(key) === reading) {
+                    this.cache.delete(key);
+                }
+            });
+        }
+        return value;
+    }
+
+    // Cache key of card details.
+    private static cardCacheKey(cardKey: string, details: fetchCardDetails = {}): string {
+        return `card:${cardKey}:${JSON.stringify(details)}`;
+    }
+
+    // Removes cache entries that start with 'prefix'.
+    private forget(prefix: string) {
+        for (const key of this.cache.keys()) {
+            if (key.startsWith(prefix)) {
+                this.cache.delete(key);
+            }
+        }
+    }
+
+    // Handles a file system change in a watched area. 'filename' is relative to the area.
+    private handleChange(area: watchedArea, filename: string | null) {
+        if (!filename) {
+            this.invalidate();
+            return;
+        }
+        const parts = filename.split(sep);
+        let cardPosition = parts.length - 1;
+        while (cardPosition >= 0 && !cardNameRegEx.test(parts[cardPosition])) {
+            cardPosition--;
+        }
+        if (cardPosition === -1) {
+            if (area === 'cardroot') {
+                this.cardTreeChanged();
+            } else {
+                this.resourcesChanged();
+            }
+            return;
+        }
+
+        // Change in a card (either project card, or template card).
+        const cardKey = parts[cardPosition];
+        const changedFile = parts.slice(cardPosition + 1);
+        this.forget(`card:${cardKey}:`);
+        if (changedFile.length === 1 && changedFile[0] === Project.cardContentFile ||
+            changedFile[0] === 'a') {
+            // Content and attachments are not part of the card tree.
+            return;
+        }
+        // Card was added, moved, removed or its metadata changed; parent's children changed as well.
+        if (cardPosition >= 2 && parts[cardPosition - 1] === 'c') {
+            this.forget(`card:${parts[cardPosition - 2]}:`);
+        }
+        if (area === 'cardroot') {
+            this.cardTreeChanged();
+        }
+    }
+
+    // Removes cached items that depend on the project card tree.
+    private cardTreeChanged() {
+        this.forget('cards');
+        this.forget('project');
+    }
+
+    // Starts watching project cards and resources.
+    private startWatching() {
+        const areas: watchedArea[] = ['cardroot', '.cards'];
+        try {
+            for (const area of areas) {
+                const watcher = watch(join(this.projectPath, area), { recursive: true }, (_event, filename) => {
+                    this.handleChange(area, filename);
+                });
+                watcher.on('error', () => this.stopWatching());
+                // Watching must not keep the process alive.
+                watcher.unref();
+                this.watchers.push(watcher);
+            }
+        } catch {
+            // File system cannot be watched; session works without caching.
+            this.stopWatching();
+        }
+    }
+
+    // Stops watching; nothing is cached after this.
+    private stopWatching() {
+        this.watchers.forEach(watcher => watcher.close());
+        this.watchers = [];
+        this.invalidate();
+    }
+
+    // Checks if file system changes are being watched.
+    private get watching(): boolean {
+        return this.watchers.length > 0;
+    }
+
+    /**
+     * Returns details of a card (project card, or template card).
+     * Calculated fields are not kept in the session; they can change when other cards change.
+     * They come from the calculation cache instead, and the solver is not waited for. If the
+     * calculated fields of the card are not in the cache, they are calculated in the background;
+     * card has then no calculated fields, and 'calculationJob' is the id of the calculation job.
+     * @param {string} cardKey card key
+     * @param {fetchCardDetails} details which details to include in the card
+     * @returns card details
+     * @throws if card does not exist in the project
+     */
+    public async cardDetails(cardKey: string, details: fetchCardDetails): Promise<card> {
+        const project = this.project;
+        if (details.calculations) {
+            const otherDetails = { ...details };
+            delete otherDetails.calculations;
+            const card = await this.cardDetails(cardKey, otherDetails);
+            const calculated = await new Calculate().cachedCardCalculations(project, [cardKey]);
+            return calculated.job
+                ? { ...card, calculationJob: calculated.job.id }
+                : { ...card, calculations: calculated.calculations[cardKey] ?? [] };
+        }
+        return this.cached(ProjectSession.cardCacheKey(cardKey, details), async () => {
+            const card = await project.cardDetailsById(cardKey, details);
+            if (card === undefined) {
+                throw new Error(`Card '${cardKey}' does not exist in the project`);
+            }
+            return card;
+        });
+    }
+
+    /**
+     * Informs the session that a card was changed by this process. File system watch would
+     * notice the change as well, but slightly later.
+     * @param {string} cardKey changed card; if not given, all cards are considered changed.
+     */
+    public cardChanged(cardKey?: string) {
+        if (cardKey) {
+            this.forget(`card:${cardKey}:`);
+        } else {
+            this.forget('card:');
+        }
+        this.cardTreeChanged();
+    }
+
+    /**
+     * Returns details of a cardtype.
+     * @param {string} cardtypeName name of a cardtype
+     * @returns cardtype details
+     * @throws if cardtype does not exist in the project
+     */
+    public async cardType(cardtypeName: string): Promise<cardtype> {
+        const project = this.project;
+        return this.cached(`cardtype:${cardtypeName}`, async () => {
+            const cardtypeDetails = await project.cardType(cardtypeName);
+            if (cardtypeDetails === undefined) {
+                throw new Error(`Cardtype '${cardtypeName}' not found from the project.`);
+            }
+            return cardtypeDetails;
+        });
+    }
+
+    /**
+     * Returns details of all cardtypes in the project.
+     * @returns array of cardtype details
+     */
+    public async cardTypes(): Promise<cardtype[]> {
+        const project = this.project;
+        return this.cached('cardtypes', async () => {
+            const cardtypes = await Promise.all((await project.cardtypes())
+                .map(item => this.cardType(item.name).catch(() => undefined)));
+            return cardtypes.filter(item => item !== undefined) as cardtype[];
+        });
+    }
+
+    /**
+     * Returns project cards as a card tree. Cards have metadata, but no content.
+     * @returns top level cards of the project.
+     */
+    public async cards(): Promise<card[]> {
+        const project = this.project;
+        return this.cached('cards', () => project.showProjectCards());
+    }
+
+    /**
+     * Stops watching the project and removes the session.
+     */
+    public close() {
+        this.stopWatching();
+        ProjectSession.instances.delete(this.projectPath);
+    }
+
+    /**
+     * Returns details of all field types in the project.
+     * @returns array of field type details
+     */
+    public async fieldTypes(): Promise<fieldtype[]> {
+        const project = this.project;
+        return this.cached('fieldtypes', async () => {
+            const fieldtypes = await Promise.all((await project.fieldtypes())
+                .map(item => item.name.split('.').slice(0, -1).join('.'))
+                .sort()
+                .map(name => project.fieldType(name)));
+            return fieldtypes.filter(item => item !== undefined) as fieldtype[];
+        });
+    }
+
+    /**
+     * Returns session of a project. Sessions are shared within the process.
+     * @param {string} projectPath path to a project
+     * @returns project session
+     */
+    public static getInstance(projectPath: string): ProjectSession {
+        const path = resolve(projectPath);
+        let instance = ProjectSession.instances.get(path);
+        if (!instance) {
+            instance = new ProjectSession(path);
+            ProjectSession.instances.set(path, instance);
+        }
+        return instance;
+    }
+
+    /**
+     * Removes everything from the cache.
+     */
+    public invalidate() {
+        this.cache.clear();
+        this.projectObject = undefined;
+    }
+
+    /**
+     * Getter. Returns project object of the session.
+     */
+    public get project(): Project {
+        if (!this.projectObject || !this.watching) {
+            this.projectObject = new Project(this.projectPath);
+        }
+        return this.projectObject;
+    }
+
+    /**
+     * Informs the session that project resources (cardtypes, workflows, field types,
+     * templates, modules or project settings) have changed.
+     */
+    public resourcesChanged() {
+        this.forget('cardtype');
+        this.forget('fieldtypes');
+        this.forget('project');
+        this.forget('templates');
+        this.forget('workflows');
+        ModuleRegistry.getInstance(join(this.projectPath, '.cards', 'modules')).invalidate();
+        this.projectObject = undefined;
+    }
+
+    /**
+     * Returns details of the project.
+     * @returns project details
+     */
+    public async show(): Promise<project> {
+        const project = this.project;
+        return this.cached('project', () => project.show());
+    }
+
+    /**
+     * Returns templates of the project.
+     * @returns template resources
+     */
+    public async templates(): Promise<resource[]> {
+        const project = this.project;
+        return this.cached('templates', () => project.templates());
+    }
+
+    /**
+     * Returns details of all workflows in the project.
+     * @returns array of workflow details
+     */
+    public async workflows(): Promise<workflowMetadata[]> {
+        const project = this.project;
+        return this.cached('workflows', async () => {
+            const workflows = await Promise.all((await project.workflows())
+                .map(item => project.workflow(item.name)));
+            return workflows.filter(item => item !== undefined) as workflowMetadata[];
+        });
+    }
+}
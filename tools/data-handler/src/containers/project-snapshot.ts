@@ -0,0 +1,360 @@
+// node
+import { mkdir, readFile, rename, rm, stat, writeFile } from 'node:fs/promises';
+import { readFileSync, statSync } from 'node:fs';
+import { join, relative, resolve, sep } from 'node:path';
+
+// ismo
+import { cardIndexState, cardMetadata, resource } from '../interfaces/project-interfaces.js';
+import { IOScheduler, ioPriority } from '../utils/io-scheduler.js';
+
+// Cached content of one card metadata file.
+interface cachedMetadata {
+    mtimeMs: number
+    size: number
+    cachedAt: number
+    metadata: cardMetadata
+}
+
+// Cached list of resources in one resource folder.
+interface cachedResources {
+    mtimeMs: number
+    cachedAt: number
+    resources: resource[]
+}
+
+// Stored card index and card metadata. Paths are relative to the project folder.
+interface cardsContent {
+    version: number
+    indexes: Record<string, cardIndexState>
+    metadata: Record<string, cachedMetadata>
+}
+
+// Stored resource lists. Paths are relative to the project folder.
+interface resourcesContent {
+    version: number
+    resources: Record<string, cachedResources>
+}
+
+/**
+ * Snapshot of project state stored in '.calc/snapshot': card index (card keys and tree shape),
+ * card metadata and resource lists. Each stored item has the modification time (and size) of
+ * the file or folder it was read from, so that only changed items need to be read again.
+ * Snapshot is a cache, and is kept outside of the versioned '.cards' folder.
+ * Resource lists and card data are stored to separate files; resource lists are needed
+ * already when a Project is constructed, card data is loaded only when cards are read.
+ * Metadata of at most 'maxCards' cards is kept; least recently read cards are dropped first,
+ * so that the snapshot stays small enough to be loaded and written as a whole.
+ * Snapshot is shared by all Project objects of the same project.
+ */
+export class ProjectSnapshot {
+
+    private static instances: Map<string, ProjectSnapshot> = new Map();
+
+    private cardsDirty: boolean = false;
+    private cardsLoaded: boolean = false;
+    private cardsLoading?: Promise<void>;
+    private forgotten: string[] = [];
+    private indexes: Map<string, cardIndexState> = new Map();
+    private indexProviders: Map<string, () => cardIndexState | undefined> = new Map();
+    private metadata: Map<string, cachedMetadata> = new Map();
+    private projectPath: string;
+    private resourceLists: Map<string, cachedResources> = new Map();
+    private resourcesDirty: boolean = false;
+    private resourcesLoaded: boolean = false;
+
+    static cardsFileName = 'cards.json';
+    static folderName = 'snapshot';
+    static maxCards = 10000;
+    // Files changed this soon after they were cached might have the same modification time
+    // as when they were cached; such items are not trusted.
+    static racyWindowMs = 2000;
+    static resourcesFileName = 'resources.json';
+    static version = 2;
+
+    constructor(projectPath: string) {
+        this.projectPath = resolve(projectPath);
+    }
+
+    // Reads stored card index and card metadata. Items that are already in memory are newer than the stored ones.
+    private async doLoadCards() {
+        try {
+            const content: cardsContent = JSON.parse(await readFile(this.cardsFile, { encoding: 'utf-8' }));
+            if (content.version !== ProjectSnapshot.version) {
+                return;
+            }
+            // Items in memory have been read more recently than the stored ones.
+            const stored = Object.entries(content.metadata || {})
+                .filter(([path]) => !this.metadata.has(path) && !this.isForgotten(path));
+            this.metadata = new Map([...stored, ...this.metadata]);
+            this.trimMetadata();
+            for (const [path, item] of Object.entries(content.indexes || {})) {
+                if (!this.indexes.has(path)) {
+                    this.indexes.set(path, item);
+                }
+            }
+        } catch {
+            // Snapshot does not exist, or cannot be read; it will be re-created.
+        } finally {
+            this.cardsLoaded = true;
+            this.forgotten = [];
+        }
+    }
+
+    // Checks if an item has been removed before the stored items were loaded.
+    private isForgotten(path: string): boolean {
+        return this.forgotten.some(prefix => path.startsWith(prefix));
+    }
+
+    // Checks if cached item can be trusted.
+    private static isTrusted(mtimeMs: number, cachedAt: number): boolean {
+        return cachedAt - mtimeMs > ProjectSnapshot.racyWindowMs;
+    }
+
+    // Loads stored card index and card metadata, if they have not been loaded yet.
+    private async loadCards() {
+        if (this.cardsLoaded) {
+            return;
+        }
+        if (!this.cardsLoading) {
+            this.cardsLoading = this.doLoadCards();
+        }
+        await this.cardsLoading;
+    }
+
+    // Reads stored resource lists synchronously; used when resources are read in Project constructor.
+    private loadResources() {
+        if (this.resourcesLoaded) {
+            return;
+        }
+        try {
+            const content: resourcesContent = JSON.parse(readFileSync(this.resourcesFile, { encoding: 'utf-8' }));
+            if (content.version === ProjectSnapshot.version) {
+                for (const [path, item] of Object.entries(content.resources || {})) {
+                    if (!this.resourceLists.has(path)) {
+                        this.resourceLists.set(path, item);
+                    }
+                }
+            }
+        } catch {
+            // Snapshot does not exist, or cannot be read; it will be re-created.
+        } finally {
+            this.resourcesLoaded = true;
+        }
+    }
+
+    // Returns path relative to project folder.
+    private relativePath(path: string): string {
+        return relative(this.projectPath, path);
+    }
+
+    // Returns path to the file of stored card index and card metadata.
+    private get cardsFile(): string {
+        return join(this.snapshotFolder, ProjectSnapshot.cardsFileName);
+    }
+
+    // Returns path to the file of stored resource lists.
+    private get resourcesFile(): string {
+        return join(this.snapshotFolder, ProjectSnapshot.resourcesFileName);
+    }
+
+    // Returns path to the snapshot folder.
+    private get snapshotFolder(): string {
+        return join(this.projectPath, '.calc', ProjectSnapshot.folderName);
+    }
+
+    // Drops metadata of least recently read cards, so that at most 'maxCards' cards are kept.
+    private trimMetadata() {
+        for (const key of this.metadata.keys()) {
+            if (this.metadata.size <= ProjectSnapshot.maxCards) {
+                break;
+            }
+            this.metadata.delete(key);
+            this.cardsDirty = true;
+        }
+    }
+
+    // Writes 'content' to 'file'. Write goes to a temporary file first, so that a partially written file is never read.
+    private static async write(file: string, content: cardsContent | resourcesContent) {
+        const temporaryFile = `${file}.${process.pid}.tmp`;
+        try {
+            await writeFile(temporaryFile, JSON.stringify(content), { encoding: 'utf-8' });
+            await rename(temporaryFile, file);
+        } catch (error) {
+            await rm(temporaryFile, { force: true });
+            throw error;
+        }
+    }
+
+    /**
+     * Returns stored state of a card index.
+     * @param {string} root card index root folder
+     * @returns stored card index state, or undefined if there is no stored state.
+     */
+    public async cardIndexState(root: string): Promise<cardIndexState | undefined> {
+        await this.loadCards();
+        return this.indexes.get(this.relativePath(root));
+    }
+
+    /**
+     * Reads card metadata. Metadata is read from the snapshot, if the metadata file has not
+     * changed since it was stored.
+     * @param {string} metadataFile path to card's metadata file
+     * @param {ioPriority} priority priority of file system operations
+     * @returns card metadata
+     */
+    public async cardMetadata(metadataFile: string, priority: ioPriority = 'background'): Promise<cardMetadata> {
+        await this.loadCards();
+        const scheduler = IOScheduler.getInstance();
+        const key = this.relativePath(metadataFile);
+        const stats = await scheduler.schedule(() => stat(metadataFile), priority);
+        const cached = this.metadata.get(key);
+        if (cached &&
+            cached.mtimeMs === stats.mtimeMs &&
+            cached.size === stats.size &&
+            ProjectSnapshot.isTrusted(cached.mtimeMs, cached.cachedAt)) {
+            // Most recently read cards are kept last.
+            this.metadata.delete(key);
+            this.metadata.set(key, cached);
+            return structuredClone(cached.metadata);
+        }
+        const metadata = JSON.parse(await scheduler.schedule(() => readFile(metadataFile, { encoding: 'utf-8' }), priority));
+        this.metadata.delete(key);
+        this.metadata.set(key, { mtimeMs: stats.mtimeMs, size: stats.size, cachedAt: Date.now(), metadata: metadata });
+        this.cardsDirty = true;
+        this.trimMetadata();
+        return structuredClone(metadata);
+    }
+
+    /**
+     * Removes stored items of a card (and cards underneath it).
+     * @param {string} cardPath path to card folder
+     */
+    public forget(cardPath: string) {
+        const prefix = this.relativePath(cardPath) + sep;
+        if (!this.cardsLoaded) {
+            this.forgotten.push(prefix);
+            this.cardsDirty = true;
+        }
+        for (const key of this.metadata.keys()) {
+            if (key.startsWith(prefix)) {
+                this.metadata.delete(key);
+                this.cardsDirty = true;
+            }
+        }
+    }
+
+    /**
+     * Returns snapshot instance of a project.
+     * @param {string} projectPath path to project
+     * @returns snapshot of the project.
+     */
+    public static getInstance(projectPath: string): ProjectSnapshot {
+        const path = resolve(projectPath);
+        let instance = ProjectSnapshot.instances.get(path);
+        if (!instance) {
+            instance = new ProjectSnapshot(path);
+            ProjectSnapshot.instances.set(path, instance);
+        }
+        return instance;
+    }
+
+    /**
+     * Informs snapshot that a card index has changed. State of the index is fetched when snapshot is saved.
+     * @param {string} root card index root folder
+     * @param {() => cardIndexState | undefined} state function that returns current state of the index.
+     */
+    public indexChanged(root: string, state: () => cardIndexState | undefined) {
+        this.indexProviders.set(this.relativePath(root), state);
+        this.cardsDirty = true;
+    }
+
+    /**
+     * Returns snapshot of the project that contains 'path'.
+     * @param {string} path path inside a project
+     * @returns snapshot of the project, or undefined if project has no snapshot instance.
+     */
+    public static owning(path: string): ProjectSnapshot | undefined {
+        const fullPath = resolve(path);
+        for (const [projectPath, instance] of ProjectSnapshot.instances) {
+            if (fullPath.startsWith(projectPath + sep)) {
+                return instance;
+            }
+        }
+        return undefined;
+    }
+
+    /**
+     * Returns resources of a resource folder. List is returned from the snapshot, if
+     * the folder has not changed since the list was stored.
+     * @param {string} folder resource folder
+     * @param {string} requirement type of resource ('file' or 'folder')
+     * @param {() => resource[]} read function that reads the resources from the folder.
+     * @returns resources in the folder.
+     */
+    public resources(folder: string, requirement: string, read: () => resource[]): resource[] {
+        this.loadResources();
+        const stats = statSync(folder, { throwIfNoEntry: false });
+        if (!stats) {
+            return read();
+        }
+        const key = `${this.relativePath(folder)}:${requirement}`;
+        const cached = this.resourceLists.get(key);
+        if (cached &&
+            cached.mtimeMs === stats.mtimeMs &&
+            ProjectSnapshot.isTrusted(cached.mtimeMs, cached.cachedAt)) {
+            return cached.resources.map(item => ({
+                name: item.name,
+                ...(item.path !== undefined) && { path: join(this.projectPath, item.path) }
+            }));
+        }
+        const resources = read();
+        this.resourceLists.set(key, {
+            mtimeMs: stats.mtimeMs,
+            cachedAt: Date.now(),
+            resources: resources.map(item => ({
+                name: item.name,
+                ...(item.path !== undefined) && { path: this.relativePath(item.path) }
+            }))
+        });
+        this.resourcesDirty = true;
+        return resources;
+    }
+
+    /**
+     * Writes snapshot files that have changed since they were loaded.
+     */
+    public async save() {
+        if (!this.cardsDirty && !this.resourcesDirty) {
+            return;
+        }
+        try {
+            await mkdir(this.snapshotFolder, { recursive: true });
+            if (this.cardsDirty) {
+                await this.loadCards();
+                for (const [root, state] of this.indexProviders) {
+                    const current = state();
+                    if (current) {
+                        this.indexes.set(root, current);
+                    } else {
+                        this.indexes.delete(root);
+                    }
+                }
+                await ProjectSnapshot.write(this.cardsFile, {
+                    version: ProjectSnapshot.version,
+                    indexes: Object.fromEntries(this.indexes),
+                    metadata: Object.fromEntries(this.metadata),
+                });
+                this.cardsDirty = false;
+            }
+            if (this.resourcesDirty) {
+                await ProjectSnapshot.write(this.resourcesFile, {
+                    version: ProjectSnapshot.version,
+                    resources: Object.fromEntries(this.resourceLists),
+                });
+                this.resourcesDirty = false;
+            }
+        } catch {
+            // Snapshot is an optimization; project might be read-only.
+        }
+    }
+}
@@ -1,12 +1,16 @@
 // node
-import { basename, dirname, join, resolve, sep } from 'node:path';
-import { Dirent, readdirSync } from 'node:fs';
-import { readdir } from 'node:fs/promises';
+import { basename, join, relative, resolve, sep } from 'node:path';
+import { readdirSync } from 'node:fs';
+import { stat } from 'node:fs/promises';
 
 // ismo
-import { attachmentDetails, card, cardListContainer, cardNameRegEx, cardtype, fetchCardDetails, fieldtype, metadataContent, moduleSettings, project, projectSettings, resource, workflowMetadata } from '../interfaces/project-interfaces.js';
-import { getFilesSync, pathExists } from '../utils/file-utils.js';
+import { Calculate } from '../calculate.js';
+import { CardIndex } from './card-index.js';
+import { ModuleRegistry, moduleResourceType } from './module-registry.js';
+import { attachmentDetails, calculatedField, card, cardIndexEntry, cardListContainer, cardtype, customField, fetchCardDetails, fieldtype, metadataContent, moduleSettings, project, resource, workflowMetadata } from '../interfaces/project-interfaces.js';
+import { pathExists } from '../utils/file-utils.js';
 import { ProjectSettings } from '../project-settings.js';
+import { ProjectSnapshot } from './project-snapshot.js';
 import { readJsonFile } from '../utils/json.js';
 import { Template } from './template.js';
 import { Validate } from '../validate.js';
@@ -20,6 +24,7 @@ import { CardContainer } from './card-container.js';
 export class Project extends CardContainer {
 
     private settings: ProjectSettings;
+    private snapshot: ProjectSnapshot;
     private validator: Validate;
 
     private localCalculations: resource[] = [];
@@ -28,10 +33,16 @@ export class Project extends CardContainer {
     private localTemplates: resource[] = [];
     private localWorkflows: resource[] = [];
 
+    // Content of cardtype and fieldtype files; a file is read again when its modification time or size changes.
+    private jsonCache: Map<string, { mtimeMs: number, size: number, content: Promise<unknown> }> = new Map();
+    // Template objects; created once per project object.
+    private templateCache: Map<string, Promise<Template>> = new Map();
+
     constructor(path: string) {
         super(path, '');
 
         this.settings = ProjectSettings.getInstance(this.projectSettingFile);
+        this.snapshot = ProjectSnapshot.getInstance(this.basePath);
         this.containerName = this.settings.name;
         // todo: implement project validation
         this.validator = Validate.getInstance();
@@ -43,49 +54,83 @@ export class Project extends CardContainer {
         this.localWorkflows = this.resourcesSync('workflow', 'file');
     }
 
-    // Add resources to an array.
-    private async addResources(resources: Dirent[], requestedType: string): Promise<resource[]> {
-        const collectedResources: resource[] = [];
-        const filteredDirectories = (requestedType === 'templates') ? true : false;
-        for (const resource of resources) {
-            if (requestedType === 'modules') {
-                collectedResources.push(...resources);
-            } else {
-                const resourcePath = join(this.modulesFolder, resource.name, requestedType);
-                const files = await readdir(resourcePath, { withFileTypes: true });
-                const filteredFiles = filteredDirectories
-                    ? files.filter(item => item.isDirectory())
-                    : files.filter(item => item.name !== Project.schemaContentFile);
-
-                filteredFiles.forEach(item => {
-                    item.name = `${resource.name}/${item.name}`;
-                    collectedResources.push({ name: item.name, path: item.path });
-                });
+    // Sets calculated fields to the cards and their children, if 'details' requests them.
+    // All the cards are calculated together.
+    private async addCalculations(cards: card[], details: fetchCardDetails) {
+        if (!details.calculations) {
+            return;
+        }
+        const allCards = Project.flattenCards(cards);
+        const calculations = await this.cardCalculations(allCards.map(card => card.key));
+        for (const card of allCards) {
+            card.calculations = calculations[card.key] ?? [];
+        }
+    }
+
+    // Returns content of a JSON file. Content is read again only if the file has changed since it was read.
+    // Callers get copies, so that they can modify the content.
+    private async cachedJson(file: string): Promise<unknown> {
+        const stats = await stat(file);
+        let cached = this.jsonCache.get(file);
+        if (!cached || cached.mtimeMs !== stats.mtimeMs || cached.size !== stats.size) {
+            cached = { mtimeMs: stats.mtimeMs, size: stats.size, content: readJsonFile(file) };
+            this.jsonCache.set(file, cached);
+        }
+        try {
+            return structuredClone(await cached.content);
+        } catch (error) {
+            if (this.jsonCache.get(file) === cached) {
+                this.jsonCache.delete(file);
             }
+            throw error;
         }
-        return collectedResources;
     }
 
-    // Collect resources from modules
-    private async collectResourcesFromModules(type: string): Promise<resource[]> {
-        if (!pathExists(this.modulesFolder)) {
-            return [];
+    // Finds a resource; resources with module prefix are found from the module registry.
+    private async findResource(type: moduleResourceType, localResources: resource[], name: string): Promise<resource | undefined> {
+        if (name.includes('/')) {
+            return this.moduleRegistry.find(type, name);
+        }
+        return localResources.find(item => item.name === name && item.path);
+    }
+
+    // Finds a template card using template card indexes. Indexes are first searched as they are.
+    // Only if card is not found, indexes are updated; templates that can contain the card
+    // based on its key prefix are updated and searched first. Local template cards use
+    // project's prefix and module template cards use module's prefix.
+    private async findTemplateCard(cardKey: string): Promise<{ folder: string, entry: cardIndexEntry } | undefined> {
+        const search = async (templates: resource[], refresh: boolean) => {
+            const found = await Promise.all(templates.map(async template => {
+                const folder = Project.templateCardsFolder(template);
+                return { folder: folder, entry: await this.containerIndex(folder).find(cardKey, refresh) };
+            }));
+            const templateCard = found.find(item => item.entry && item.entry.key !== CardIndex.rootKey);
+            return templateCard ? { folder: templateCard.folder, entry: templateCard.entry as cardIndexEntry } : undefined;
+        };
+
+        const templates = await this.templates();
+        const indexed = await search(templates, false);
+        if (indexed) {
+            return indexed;
         }
+        const prefix = cardKey.split('_')[0];
+        const moduleName = prefix === this.projectPrefix ? undefined : await this.moduleRegistry.moduleByPrefix(prefix);
+        const owningTemplates = prefix === this.projectPrefix
+            ? templates.filter(template => !template.name.includes('/'))
+            : moduleName ? templates.filter(template => template.name.startsWith(`${moduleName}/`)) : [];
 
-        const moduleDirectories = await readdir(this.modulesFolder, { withFileTypes: true });
-        const modules = moduleDirectories.filter(item => item.isDirectory());
+        return await search(owningTemplates, true) ||
+            await search(templates.filter(template => !owningTemplates.includes(template)), true);
+    }
 
-        return [...(await this.addResources(modules, type))];
+    // Returns cards and all of their descendants as one list.
+    private static flattenCards(cards: card[]): card[] {
+        return cards.flatMap(card => [card, ...Project.flattenCards(card.children ?? [])]);
     }
 
-    // Finds specific module.
-    private async findSpecificModule(moduleName: string): Promise<resource | undefined> {
-        const found = (await this.collectResourcesFromModules('modules'))
-            .find(item => item.name === moduleName);
-        if (!found || !found.path) {
-            return undefined;
-        }
-        return found;
+    // Returns registry of project's modules.
+    private get moduleRegistry(): ModuleRegistry {
+        return ModuleRegistry.getInstance(this.modulesFolder);
     }
 
     // Returns path to project configuration.
@@ -93,45 +138,63 @@ export class Project extends CardContainer {
         return join(this.resourcesFolder, Project.projectConfigFileName);
     }
 
-    // Reads cardtree to memory. This is with minimal information (e.g no attachments, no content).
-    // todo: combine with function of same in Export; add here booleans 'include content', 'include attachments'
-    private async readCardTreeToMemory(cardrootPath: string, cards?: card[]) {
+    // Reads cardtype and merges details of its custom fields from field types.
+    private async readCardtype(cardTypeName: string): Promise<cardtype | undefined> {
+        const found = await this.findResource('cardtypes', this.localCardtypes, cardTypeName);
 
-        // Finds card from already collected cards using filename path.
-        function findCard(path: string, cards: card[] | undefined) {
-            return cards?.find(card => card.key === basename(path));
+        if (!found || !found.path) {
+            return undefined;
         }
-
-        // Filter out the schema validation files.
-        let entries = await readdir(cardrootPath, { withFileTypes: true });
-        entries = entries.filter(entry => {
-            return entry.name !== Project.schemaContentFile;
-        });
-
-        // Loop through all the found file entries and collect found cards.
-        for (const entry of entries) {
-            if (entry.isDirectory() && cardNameRegEx.test(entry.name)) {
-                // Card directory (e.g. 'decision_11')
-                cards?.push({
-                    key: entry.name,
-                    path: join(entry.path, entry.name),
-                    children: []
-                });
-                await this.readCardTreeToMemory(join(entry.path, entry.name), cards);
-            } else if (entry.isDirectory() && entry.name === 'c') {
-                // Subdirectory 'c' of card directory.
-                const found = findCard(entry.path, cards);
-                if (found) {
-                    await this.readCardTreeToMemory(join(entry.path, entry.name), found.children);
+        // todo: somehow should automatically fill-in 'default' values.
+        const content = await this.cachedJson(join(found.path, basename(found.name))) as cardtype;
+        if (content.customFields) {
+            const fieldTypes = await Promise.all(content.customFields.map(
+                (item: customField) => this.fieldType(item.name)));
+            for (const [index, item] of content.customFields.entries()) {
+                // Set "isEditable" if it is missing; default = true
+                if (item.isEditable === undefined) {
+                    item.isEditable = true;
                 }
-            } else if (entry.isFile() && entry.name === Project.cardMetadataFile) {
-                // Metadata file in card directory.
-                const found = findCard(entry.path, cards);
-                if (found) {
-                    found.metadata = await readJsonFile(join(entry.path, entry.name));
+                // Fetch displayName from field type
+                if (item.name) {
+                    const fieldType = fieldTypes[index];
+                    if (fieldType) {
+                        if (item.displayName === undefined) item.displayName = fieldType.displayName;
+                        if (item.description === undefined) item.description = fieldType.fieldDescription;
+                    } else {
+                        console.error(`Missing fieldType '${item.name}' in cardType '${cardTypeName}'`);
+                        return undefined;
+                    }
+                } else {
+                    console.error(`Custom field '${item.name}' is missing mandatory 'name' in cardType '${cardTypeName}'`);
+                    return undefined;
                 }
             }
         }
+        return content;
+    }
+
+    // Reads resources from a resource folder.
+    private readResourceFolder(resourceFolder: string, requirement: string): resource[] {
+        const resources: resource[] = [];
+        const entries = readdirSync(resourceFolder, { withFileTypes: true });
+        resources.push(
+            ...entries
+                .filter(entry => {
+                    return !(entry.isFile() && entry.name === Project.schemaContentFile);
+                })
+                .filter(entry => {
+                    return !(entry.isFile() && entry.name === '.gitkeep');
+                })
+                .filter(entry => {
+                    return requirement === 'folder' ? entry.isDirectory() : requirement === 'file' ? entry.isFile() : false;
+                })
+                .map(entry => {
+                    return { name: entry.name, path: entry.path };
+                })
+        );
+
+        return resources;
     }
 
     // Collects certain kinds of resources.
@@ -151,31 +214,13 @@ export class Project extends CardContainer {
             return [];
         }
 
-        const resources: resource[] = [];
         if (!pathExists(resourceFolder)) {
             // for some reason, the specific resource folder does not exists
             console.error(`Cannot find folder '${resourceFolder}'`);
             // todo: automatically create resource folder with correct .schema file.
             return [];
         }
-        const entries = readdirSync(resourceFolder, { withFileTypes: true });
-        resources.push(
-            ...entries
-                .filter(entry => {
-                    return !(entry.isFile() && entry.name === Project.schemaContentFile);
-                })
-                .filter(entry => {
-                    return !(entry.isFile() && entry.name === '.gitkeep');
-                })
-                .filter(entry => {
-                    return requirement === 'folder' ? entry.isDirectory() : requirement === 'file' ? entry.isFile() : false;
-                })
-                .map(entry => {
-                    return { name: entry.name, path: entry.path };
-                })
-        );
-
-        return resources;
+        return this.snapshot.resources(resourceFolder, requirement, () => this.readResourceFolder(resourceFolder, requirement));
     }
 
     /**
@@ -205,7 +250,7 @@ export class Project extends CardContainer {
      * @returns array of all calculation files in the project.
      */
     public async calculations(): Promise<resource[]> {
-        const moduleCalculations = await this.collectResourcesFromModules('calculations');
+        const moduleCalculations = await this.moduleRegistry.resources('calculations');
         return [
             ...this.localCalculations,
             ...moduleCalculations
@@ -226,12 +271,22 @@ export class Project extends CardContainer {
             return join(cardPath, 'a');
         }
 
-        const pathToProjectCard = this.pathToCard(cardKey);
+        const pathToProjectCard = await this.pathToCard(cardKey);
         return pathToProjectCard
             ? join(this.cardrootFolder, pathToProjectCard, 'a')
             : '';
     }
 
+    /**
+     * Returns calculated fields of cards. Cached results are used when they are up to date;
+     * other cards are calculated together with one solve.
+     * @param {string[]} cardKeys card keys
+     * @returns calculated fields of each card; cards without calculated fields are not included.
+     */
+    public async cardCalculations(cardKeys: string[]): Promise<{ [cardKey: string]: calculatedField[] }> {
+        return new Calculate().cardCalculations(this, cardKeys);
+    }
+
     /**
      * Returns details (as defined by cardDetails) of a card.
      * @param {string} cardKey card key (project prefix and a number, e.g. test_1)
@@ -254,16 +309,32 @@ export class Project extends CardContainer {
         if (found) {
             return found.path;
         }
+        const templateCard = await this.findTemplateCard(cardKey);
+        return templateCard ? templateCard.entry.path : '';
+    }
 
-        const templates = await this.templates();
-        const templatePromises = templates.map(async template => {
-            const templateObject = await this.createTemplateObject(template);
-            const templateCard = templateObject ? await templateObject.findSpecificCard(cardKey) : undefined;
-            return templateCard ? templateCard.path : '';
-        });
+    /**
+     * Getter. Returns index of project cards.
+     */
+    public get cardIndex(): CardIndex {
+        return this.containerIndex(this.cardrootFolder);
+    }
 
-        const templatePaths = await Promise.all(templatePromises);
-        return templatePaths.find(path => path !== '') || '';
+    /**
+     * Reads project cards to memory as a card tree. Tree is read in one pass.
+     * @param {fetchCardDetails} details Which details to include in the cards. Children are always included.
+     * @param {string} cardKey Optional; if defined, returns the card tree underneath this card.
+     * @returns top level cards of the tree, or the card defined by 'cardKey'.
+     */
+    public async cardTree(details: fetchCardDetails = {}, cardKey?: string): Promise<card[]> {
+        if (cardKey) {
+            const card = await this.findCard(this.cardrootFolder, cardKey, { ...details, children: true });
+            await this.addCalculations(card ? [card] : [], details);
+            return card ? [card] : [];
+        }
+        const cards = await this.readCardTree(this.cardrootFolder, details);
+        await this.addCalculations(cards, details);
+        return cards;
     }
 
     /**
@@ -282,7 +353,9 @@ export class Project extends CardContainer {
     public async cards(
         path: string = this.cardrootFolder,
         details: fetchCardDetails = { content: true, metadata: true }): Promise<card[]> {
-        return super.cards(path, details);
+        const cards = await super.cards(path, details);
+        await this.addCalculations(cards, details);
+        return cards;
     }
 
     /**
@@ -295,37 +368,7 @@ export class Project extends CardContainer {
         if (!cardTypeName.endsWith('.json')) {
             cardTypeName += '.json';
         }
-        const found = (await this.cardtypes())
-            .find(item => item.name === cardTypeName && item.path);
-
-        if (!found || !found.path) {
-            return undefined;
-        }
-        // todo: somehow should automatically fill-in 'default' values.
-        const content = await readJsonFile(join(found.path, basename(found.name)));
-        if (content.customFields) {
-            for (const item of content.customFields) {
-                // Set "isEditable" if it is missing; default = true
-                if (item.isEditable === undefined) {
-                    item.isEditable = true;
-                }
-                // Fetch displayName from field type
-                if (item.name) {
-                    const fieldType = await this.fieldType(item.name);
-                    if (fieldType) {
-                        if (item.displayName === undefined) item.displayName = fieldType.displayName;
-                        if (item.description === undefined) item.description = fieldType.fieldDescription;
-                    } else {
-                        console.error(`Missing fieldType '${item.name}' in cardType '${cardTypeName}'`);
-                        return undefined;
-                    }
-                } else {
-                    console.error(`Custom field '${item.name}' is missing mandatory 'name' in cardType '${cardTypeName}'`);
-                    return undefined;
-                }
-            }
-        }
-        return content;
+        return this.readCardtype(cardTypeName);
     }
 
     /**
@@ -333,7 +376,7 @@ export class Project extends CardContainer {
      * @returns array of all cardtypes in the project.
      */
     public async cardtypes(): Promise<resource[]> {
-        const moduleCardtypes = await this.collectResourcesFromModules('cardtypes');
+        const moduleCardtypes = await this.moduleRegistry.resources('cardtypes');
         return [
             ...this.localCardtypes,
             ...moduleCardtypes
@@ -361,15 +404,33 @@ export class Project extends CardContainer {
      * @returns Template object, or undefined if template does not exist in the project.
      */
     public async createTemplateObject(template: resource): Promise<Template | undefined> {
-        template.name = Template.normalizedTemplateName(template.name);
+        const name = Template.normalizedTemplateName(template.name);
+        template.name = name;
 
-        if (template.name === '' || !(await this.templateExists(template.name))) {
+        if (name === '' || !(await this.templateExists(name))) {
+            this.templateCache.delete(name);
             return undefined;
         }
 
-        const templateObject = new Template(this.basePath, template, this);
-        await templateObject.create({ buttonLabel: '', namePrompt: '' });
-        return templateObject;
+        let templateObject = this.templateCache.get(name);
+        if (templateObject && !(await templateObject).isCreated()) {
+            // Template folder was removed after the object was created.
+            templateObject = undefined;
+        }
+        if (!templateObject) {
+            templateObject = (async () => {
+                const created = new Template(this.basePath, { ...template }, this);
+                await created.create({ buttonLabel: '', namePrompt: '' });
+                return created;
+            })();
+            this.templateCache.set(name, templateObject);
+        }
+        try {
+            return await templateObject;
+        } catch (error) {
+            this.templateCache.delete(name);
+            throw error;
+        }
     }
 
     /**
@@ -393,13 +454,11 @@ export class Project extends CardContainer {
         if (!fieldTypeName.endsWith('.json')) {
             fieldTypeName += '.json';
         }
-        const found = (await this.fieldtypes())
-            .find(item => item.name === fieldTypeName && item.path);
-
+        const found = await this.findResource('fieldtypes', this.localFieldtypes, fieldTypeName);
         if (!found || !found.path) {
             return undefined;
         }
-        return readJsonFile(join(found.path, basename(found.name)));
+        return await this.cachedJson(join(found.path, basename(found.name))) as fieldtype;
     }
 
     /**
@@ -407,7 +466,7 @@ export class Project extends CardContainer {
      * @returns array of all cardtypes in the project.
      */
     public async fieldtypes(): Promise<resource[]> {
-        const moduleFieldtypes = await this.collectResourcesFromModules('fieldtypes');
+        const moduleFieldtypes = await this.moduleRegistry.resources('fieldtypes');
         return [
             ...this.localFieldtypes,
             ...moduleFieldtypes
@@ -449,21 +508,14 @@ export class Project extends CardContainer {
      */
     public async findSpecificCard(cardKey: string, details: fetchCardDetails = {}): Promise<card | undefined> {
         const projectCard = await super.findCard(this.cardrootFolder, cardKey, details);
-        let templateCard;
-        if (!projectCard) {
-            const templates = await this.templates();
-            for (const template of templates) {
-                const templateObject = await this.createTemplateObject(template);
-                // optimize: execute each find in template parallel
-                if (templateObject) {
-                    templateCard = await templateObject.findSpecificCard(cardKey, details)
-                    if (templateCard) {
-                        break;
-                    }
-                }
-            }
+        if (projectCard) {
+            await this.addCalculations([projectCard], details);
+            return projectCard;
         }
-        return projectCard ? projectCard : templateCard;
+        const templateCard = await this.findTemplateCard(cardKey);
+        return templateCard
+            ? super.findCard(templateCard.folder, cardKey, details)
+            : undefined;
     }
 
     /**
@@ -489,7 +541,7 @@ export class Project extends CardContainer {
      * @param {string} cardKey card to check.
      * @returns true if a given card is found from project, false otherwise.
      */
-    public hasCard(cardKey: string): boolean {
+    public async hasCard(cardKey: string): Promise<boolean> {
         return super.hasCard(cardKey, this.cardrootFolder);
     }
 
@@ -511,6 +563,25 @@ export class Project extends CardContainer {
         return card.path.includes(`${sep}templates${sep}`) || card.path.includes(`${sep}modules${sep}`);
     }
 
+    /**
+     * Iterates project cards. Cards are read while they are iterated, so that the whole
+     * card tree does not need to be in memory at once. Cards are returned without children.
+     * @param {fetchCardDetails} details Which details to include in the cards.
+     * @param {string} cardKey Optional; if defined, iterates this card and the cards underneath it.
+     *                         Card can also be a template card.
+     * @returns async iterator of cards.
+     */
+    public async *iterateCards(details: fetchCardDetails = {}, cardKey?: string): AsyncGenerator<card> {
+        if (cardKey) {
+            const card = await this.findSpecificCard(cardKey);
+            if (card) {
+                yield* this.iterateCardsFrom([{ key: card.key, path: card.path }], details);
+            }
+            return;
+        }
+        yield* this.iterateCardTree(this.cardrootFolder, details);
+    }
+
     /**
      * Returns an array of all the cards in the project. Cards don't have content and nor metadata.
      * @param includeTemplateCards Whether or not to include cards in templates
@@ -518,7 +589,7 @@ export class Project extends CardContainer {
      */
     public async listAllCards(includeTemplateCards: boolean): Promise<cardListContainer[]> {
         const cardListContainer: cardListContainer[] = [];
-        const projectCards = (await super.cards(this.cardrootFolder)).map(item => item.key);
+        const projectCards = await this.cardIndex.keys();
         cardListContainer.push({
             name: this.projectName,
             type: 'project',
@@ -527,18 +598,16 @@ export class Project extends CardContainer {
 
         if (includeTemplateCards) {
             const templates = await this.templates();
-            for (const template of templates) {
+            const templateCardLists = await Promise.all(templates.map(async template => {
                 const templateObject = await this.createTemplateObject(template);
-                if (templateObject) {
-                    // todo: optimization - do all this in parallel
-                    const templateCards = await templateObject.listCards();
-                    if (templateCards) {
-                        cardListContainer.push({
-                            name: template.name,
-                            type: 'template',
-                            cards: templateCards.map(item => item.key)
-                        });
-                    }
+                const templateCards = templateObject ? await templateObject.listCards() : undefined;
+                return templateCards
+                    ? { name: template.name, type: 'template', cards: templateCards.map(item => item.key) }
+                    : undefined;
+            }));
+            for (const templateCardList of templateCardLists) {
+                if (templateCardList) {
+                    cardListContainer.push(templateCardList);
                 }
             }
         }
@@ -551,21 +620,22 @@ export class Project extends CardContainer {
      * @returns module details, or undefined if workflow cannot be found.
      */
     public async module(moduleName: string): Promise<moduleSettings | undefined> {
-        const module = await this.findSpecificModule(moduleName);
+        const module = await this.moduleRegistry.module(moduleName);
         if (module && module.path) {
             const moduleNameAndPath = join(module.path, module.name);
             const moduleConfig = await readJsonFile(join(moduleNameAndPath, Project.projectConfigFileName));
+            const registry = this.moduleRegistry;
             return {
                 name: moduleConfig.name,
                 path: moduleNameAndPath,
                 cardkeyPrefix: moduleConfig.cardkeyPrefix,
                 nextAvailableCardNumber: moduleConfig.nextAvailableCardNumber,
                 // resources:
-                calculations: [...(await this.collectResourcesFromModules('calculations')).map(item => item.name)],
-                cardtypes: [...(await this.collectResourcesFromModules('cardtypes')).map(item => item.name)],
-                fieldtypes: [...(await this.collectResourcesFromModules('fieldtypes')).map(item => item.name)],
-                templates: [...(await this.collectResourcesFromModules('templates')).map(item => item.name)],
-                workflows: [...(await this.collectResourcesFromModules('workflows')).map(item => item.name)],
+                calculations: await registry.moduleResourceNames(module.name, 'calculations'),
+                cardtypes: await registry.moduleResourceNames(module.name, 'cardtypes'),
+                fieldtypes: await registry.moduleResourceNames(module.name, 'fieldtypes'),
+                templates: await registry.moduleResourceNames(module.name, 'templates'),
+                workflows: await registry.moduleResourceNames(module.name, 'workflows'),
             }
         }
         return undefined;
@@ -576,14 +646,7 @@ export class Project extends CardContainer {
      * @returns List of module names in the project.
      */
     public async moduleNames(): Promise<string[]> {
-        const moduleNames: string[] = [];
-        if (pathExists(this.modulesFolder)) {
-            const names = await readdir(this.modulesFolder);
-            if (names) {
-                moduleNames.push(...names);
-            }
-        }
-        return moduleNames;
+        return (await this.moduleRegistry.modules()).map(item => item.name);
     }
 
     /**
@@ -592,7 +655,7 @@ export class Project extends CardContainer {
      * @returns path to a module.
      */
     public async modulePath(moduleName: string): Promise<string | undefined> {
-        const module = await this.findSpecificModule(moduleName);
+        const module = await this.moduleRegistry.module(moduleName);
         return module && module.path ? join(module.path, module.name) : undefined;
     }
 
@@ -601,7 +664,7 @@ export class Project extends CardContainer {
      * @returns list of modules in the project.
      */
     public async modules(): Promise<resource[]> {
-        return this.collectResourcesFromModules('modules');
+        return this.moduleRegistry.modules();
     }
 
     /**
@@ -612,15 +675,15 @@ export class Project extends CardContainer {
     }
 
     /**
-     * Returns full path to a given card.
+     * Returns path to a given card, relative to cardroot.
      * @param {string} cardKey card to check path for.
-     * @returns path to a given card.
+     * @returns path to a given card, or empty string if card is not in the project.
      */
-    public pathToCard(cardKey: string): string {
-        const allFiles = getFilesSync(this.cardrootFolder);
-        const cardIndexJsonFile = join(cardKey, Project.cardMetadataFile);
-        const foundFile = allFiles.find(file => file.includes(cardIndexJsonFile));
-        return foundFile ? dirname(foundFile) : '';
+    public async pathToCard(cardKey: string): Promise<string> {
+        const entry = await this.cardIndex.find(cardKey);
+        return (entry && entry.key !== CardIndex.rootKey)
+            ? relative(this.cardrootFolder, entry.path)
+            : '';
     }
 
     /**
@@ -642,23 +705,7 @@ export class Project extends CardContainer {
      * @returns all prefixes used in the project.
      */
     public async projectPrefixes(): Promise<string[]> {
-        const prefixes: string[] = [this.projectPrefix];
-        if (pathExists(this.modulesFolder)) {
-            const files = await readdir(this.modulesFolder, { withFileTypes: true, recursive: true });
-            const configurationFiles = files
-                .filter(dirent => dirent.isFile())
-                .filter(dirent => dirent.name === Project.projectConfigFileName);
-
-            const configurationPromises = configurationFiles.map(async file => {
-                const configuration: projectSettings = await readJsonFile(join(file.path, file.name));
-                return configuration.cardkeyPrefix;
-            });
-
-            const configurationPrefixes = await Promise.all(configurationPromises);
-            prefixes.push(...configurationPrefixes);
-        }
-
-        return prefixes;
+        return [this.projectPrefix, ...await this.moduleRegistry.prefixes()];
     }
 
     /**
@@ -668,6 +715,17 @@ export class Project extends CardContainer {
         return join(this.basePath, '.cards', 'local');
     }
 
+    /**
+     * Stores card index, card metadata and resource lists to the project snapshot,
+     * so that the next process does not need to read them again.
+     * Reading commands do not store the snapshot; it is stored after commands that change
+     * the project, and when the logic program is generated.
+     */
+    public async saveSnapshot() {
+        await this.cardIndex.update();
+        await this.snapshot.save();
+    }
+
     /**
      * Shows details of a project.
      * @returns details of a project.
@@ -687,9 +745,7 @@ export class Project extends CardContainer {
      * @returns an array of all project cards in the project.
      */
     public async showProjectCards(): Promise<card[]> {
-        const cards: card[] = []
-        await this.readCardTreeToMemory(this.cardrootFolder, cards);
-        return cards;
+        return this.cardTree({ metadata: true });
     }
 
     /**
@@ -739,10 +795,18 @@ export class Project extends CardContainer {
      * @returns array of all templates in the project.
      */
     public async templates(localOnly: boolean = false): Promise<resource[]> {
-        const moduleTemplates = await this.collectResourcesFromModules('templates');
         return (localOnly)
             ? [...this.localTemplates]
-            : [...this.localTemplates, ...moduleTemplates];
+            : [...this.localTemplates, ...await this.moduleRegistry.resources('templates')];
+    }
+
+    /**
+     * Returns path to template's card folder.
+     * @param {resource} template template resource
+     * @returns path to the folder that contains template's top level cards.
+     */
+    public static templateCardsFolder(template: resource): string {
+        return join(template.path || '', basename(template.name), 'c');
     }
 
     /**
@@ -758,7 +822,7 @@ export class Project extends CardContainer {
      * @param {string} content changed content
      */
     public async updateCardContent(cardKey: string, content: string) {
-        const card = await this.findCard(this.basePath, cardKey);
+        const card = await this.findSpecificCard(cardKey);
         if (!card) {
             throw new Error(`Card '${cardKey}' does not exist in the project`);
         }
@@ -773,7 +837,7 @@ export class Project extends CardContainer {
      * @param {metadataContent} newValue changed value for the key
      */
     public async updateCardMetadata(cardKey: string, changedKey: string, newValue: metadataContent) {
-        const card = await this.findCard(this.basePath, cardKey, { metadata: true });
+        const card = await this.findSpecificCard(cardKey, { metadata: true });
         type MetadataTypes = Record<string, metadataContent>;
         if (!card) {
             throw new Error(`Card '${cardKey}' does not exist in the project`);
@@ -816,8 +880,7 @@ export class Project extends CardContainer {
         if (!workflowName.endsWith('.json')) {
             workflowName += '.json';
         }
-        const found = (await this.workflows())
-            .find(item => item.name === workflowName && item.path);
+        const found = await this.findResource('workflows', this.localWorkflows, workflowName);
 
         if (!found || !found.path) {
             return undefined;
@@ -850,7 +913,7 @@ export class Project extends CardContainer {
      * @returns array of all workflows in the project.
      */
     public async workflows(): Promise<resource[]> {
-        const moduleWorkflows = await this.collectResourcesFromModules('workflows');
+        const moduleWorkflows = await this.moduleRegistry.resources('workflows');
         return [...this.localWorkflows, ...moduleWorkflows];
     }
 
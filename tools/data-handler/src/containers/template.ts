@@ -1,9 +1,10 @@
 // node
-import { basename, join, resolve, sep } from 'node:path';
+import { basename, dirname, join, resolve, sep } from 'node:path';
 import { copyFile, mkdir, rm, writeFile } from 'node:fs/promises';
 import { readdirSync } from 'node:fs';
 
 // ismo
+import { CardIndex } from './card-index.js';
 import { attachmentDetails, card, cardNameRegEx, fetchCardDetails, resource, template, templateMetadata } from '../interfaces/project-interfaces.js';
 import { copyDir, pathExists, sepRegex } from '../utils/file-utils.js';
 import { formatJson } from '../utils/json.js';
@@ -140,6 +141,17 @@ export class Template extends CardContainer {
             await rm(tempDestination, { recursive: true, force: true });
             await this.project.configuration.commit();
 
+            // Update created cards to their final location, and to the card index.
+            const destination = parentCard ? parentCard.path : this.project.cardrootFolder;
+            for (const card of cards) {
+                card.path = card.path.replace(tempDestination, destination);
+                const parentFolder = dirname(card.path);
+                const parentKey = parentFolder === this.project.cardrootFolder
+                    ? CardIndex.rootKey
+                    : basename(dirname(parentFolder));
+                await this.project.cardIndex.add(card.key, card.path, parentKey);
+            }
+
         } catch (error) {
             if (error instanceof Error) {
                 this.project.configuration.rollback();
@@ -208,7 +220,7 @@ export class Template extends CardContainer {
             if (await this.project.cardType(cardtype) === undefined) {
                 throw new Error(`Cardtype '${cardtype}' does not exist`);
             }
-            if (parentCard && !this.hasCard(parentCard.key)) {
+            if (parentCard && !await this.hasCard(parentCard.key)) {
                 throw new Error(`Card '${parentCard.key}' does not exist in template '${this.containerName}'`);
             }
 
@@ -221,6 +233,7 @@ export class Template extends CardContainer {
             await writeFile(join(templateCardToCreate, Project.cardMetadataFile), formatJson(defaultContent));
             await writeFile(join(templateCardToCreate, Project.cardContentFile), '');
             await this.project.configuration.commit();
+            await this.containerIndex(this.templateCardsPath).add(newCardKey, templateCardToCreate, parentCard ? parentCard.key : CardIndex.rootKey);
         } catch (error) {
             if (error instanceof Error) {
                 // todo: does this ever really throw?
@@ -350,7 +363,7 @@ export class Template extends CardContainer {
      * @param cardKey Card key to find from template.
      * @return true if card with a given card key exists in the template, false otherwise.
      */
-    public hasCard(cardKey: string): boolean {
+    public async hasCard(cardKey: string): Promise<boolean> {
         return super.hasCard(cardKey, this.templateCardsPath);
     }
 
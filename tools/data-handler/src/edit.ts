@@ -22,7 +22,7 @@ export class Edit {
         Edit.project = new Project(projectPath);
 
         // Determine the card path
-        const cardPath = Edit.project.pathToCard(cardKey);
+        const cardPath = await Edit.project.pathToCard(cardKey);
         if (!cardPath) {
             throw new Error(`Card '${cardKey}' does not exist in the project`);
         }
@@ -77,7 +77,7 @@ export class Edit {
         Edit.project = new Project(projectPath);
 
         // Determine the card path
-        const cardPath = Edit.project.pathToCard(cardKey);
+        const cardPath = await Edit.project.pathToCard(cardKey);
         if (!cardPath) {
             throw new Error(`Card '${cardKey}' does not exist in the project`);
         }
@@ -101,7 +101,7 @@ export class Edit {
         Edit.project = new Project(projectPath);
 
         // Determine the card path
-        const cardPath = Edit.project.pathToCard(cardKey);
+        const cardPath = await Edit.project.pathToCard(cardKey);
         if (!cardPath) {
             throw new Error(`Card '${cardKey}' does not exist in the project`);
         }
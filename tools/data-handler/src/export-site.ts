@@ -216,20 +216,7 @@ export class ExportSite extends Export {
     */
     public async exportToSite(source: string, destination: string, cardkey?: string) {
         Export.project = new Project(source);
-        const sourcePath: string = cardkey
-            ? join(Export.project.cardrootFolder, Export.project.pathToCard(cardkey))
-            : Export.project.cardrootFolder;
-        const cards: card[] = [];
-
-        // If doing a partial tree export, put the parent information as it would have already been gathered.
-        if (cardkey) {
-            cards.push({
-                key: cardkey,
-                path: sourcePath
-            });
-        }
-
-        await super.readCardTreeToMemory(sourcePath, cards);
+        const cards = await Export.project.cardTree(Export.cardDetails, cardkey);
         if (!cards.length) {
             throw new Error('No cards found');
         }
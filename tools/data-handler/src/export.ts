@@ -1,12 +1,11 @@
 // node
-import { appendFile, copyFile, mkdir, readdir, truncate } from 'node:fs/promises';
-import { basename, dirname, join, resolve, sep } from 'node:path';
+import { appendFile, copyFile, mkdir, truncate } from 'node:fs/promises';
+import { dirname, join, resolve } from 'node:path';
 
 // ismo
-import { card, cardNameRegEx, cardtype } from './interfaces/project-interfaces.js';
+import { card, cardtype } from './interfaces/project-interfaces.js';
 import { pathExists } from './utils/file-utils.js';
 import { Project } from './containers/project.js';
-import { readADocFileSync, readJsonFileSync } from './utils/json.js';
 
 // asciidoctor
 import Processor from '@asciidoctor/core';
@@ -17,73 +16,10 @@ export class Export {
 
     static project: Project;
 
-    constructor() { }
-
-    // Finds card based on name.
-    private findCard(path: string, cards: card[] | undefined) {
-        return cards?.find(card => card.key === basename(path));
-    }
-
-    // Finds owner of attachment (card) based on name.
-    private findAttachmentOwner(path: string, cards: card[] | undefined) {
-        const parts = path.split(sep);
-        const relatedCard = parts.at(parts.length - 2);
-        return cards?.find(card => card.key === relatedCard);
-    }
+    // Card details that are exported.
+    protected static cardDetails = { content: true, metadata: true, attachments: true };
 
-    // Creates memory-based representation of <project>/cardroot
-    // todo: combine with function of same in Project
-    protected async readCardTreeToMemory(cardrootPath: string, cards?: card[], unknownFileIsAttachment: boolean = false) {
-        let entries = await readdir(cardrootPath, { withFileTypes: true });
-        entries = entries.filter(entry => {
-            return entry.name !== Project.schemaContentFile;
-        });
-
-        for (const entry of entries) {
-            if (entry.isDirectory() && cardNameRegEx.test(entry.name)) {
-                cards?.push({
-                    key: entry.name,
-                    path: entry.path,
-                    children: []
-                });
-                await this.readCardTreeToMemory(join(entry.path, entry.name), cards);
-            } else if (entry.isDirectory() && entry.name === 'c') {
-                const found = this.findCard(entry.path, cards);
-                if (found) {
-                    await this.readCardTreeToMemory(join(entry.path, entry.name), found.children);
-                } else {
-                    console.error(`Cannot find card folder '${join(entry.path, entry.name)}'`);
-                }
-            } else if (entry.isDirectory() && entry.name === attachmentFolder) {
-                unknownFileIsAttachment = true;
-                await this.readCardTreeToMemory(join(entry.path, entry.name), cards, unknownFileIsAttachment);
-            } else if (entry.isFile() && entry.name === Project.cardMetadataFile) {
-                const found = this.findCard(entry.path, cards);
-                if (found) {
-                    found.metadata = readJsonFileSync(join(entry.path, entry.name));
-                } else {
-                    console.error(`Cannot find file '${join(entry.path, entry.name)}'`);
-                }
-            } else if (entry.isFile() && entry.name === Project.cardContentFile) {
-                const found = this.findCard(entry.path, cards);
-                if (found) {
-                    found.content = readADocFileSync(join(entry.path, entry.name));
-                } else {
-                    console.error(`Cannot find file '${join(entry.path, entry.name)}'`);
-                }
-            } else {
-                if (unknownFileIsAttachment) {
-                    const found = this.findAttachmentOwner(entry.path, cards);
-                    if (found) {
-                        if (!found.attachments) { found.attachments = []; }
-                        found.attachments?.push({ card: found.key, fileName: entry.name, path: entry.path });
-                    } else {
-                        console.error(`Cannot find unknown file (likely attachment) ${join(entry.path, entry.name)}`);
-                    }
-                }
-            }
-        }
-    }
+    constructor() { }
 
     // This file should set the top level items to the adoc.
     private async toAdocFile(path: string, cards: card[]) {
@@ -120,7 +56,7 @@ export class Export {
         for (const card of cards) {
             let fileContent = '';
             if (card.content) {
-                const fullPath = resolve(process.cwd(), card.path, card.key, Project.cardContentFile);
+                const fullPath = resolve(process.cwd(), card.path, Project.cardContentFile);
                 if (card.metadata?.summary) {
                     fileContent += `\n== ${card.metadata?.summary}\n`;
                 }
@@ -161,17 +97,7 @@ export class Export {
      */
     public async exportToADoc(source: string, destination: string, cardkey?: string) {
         Export.project = new Project(source);
-        const sourcePath: string = Export.project.cardrootFolder;
-        const cards: card[] = [];
-
-        // If doing a partial tree export, put the parent information as it would have already been gathered.
-        if (cardkey) {
-            cards.push({
-                key: cardkey,
-                path: sourcePath
-            });
-        }
-        await this.readCardTreeToMemory(sourcePath, cards);
+        const cards = await Export.project.cardTree(Export.cardDetails, cardkey);
 
         // Return cards in numeric order.
         cards.sort((a, b) => {
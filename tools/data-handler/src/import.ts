@@ -5,6 +5,7 @@ import { readdir, writeFile } from 'node:fs/promises';
 // ismo
 import { copyDir } from './utils/file-utils.js';
 import { formatJson, readJsonFile } from './utils/json.js';
+import { ModuleRegistry } from './containers/module-registry.js';
 import { Project } from './containers/project.js';
 
 export class Import {
@@ -74,5 +75,7 @@ export class Import {
             content.name = `${moduleName}/${content.name}`;
             writeFile(join(file.path, file.name), formatJson(content));
         }
+
+        await ModuleRegistry.getInstance(destinationProject.modulesFolder).add(moduleName);
     }
 }
\ No newline at end of file
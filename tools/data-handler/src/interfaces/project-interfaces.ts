@@ -39,6 +39,13 @@ export interface projectFile {
     name: string
 }
 
+// Calculated field of a card.
+export interface calculatedField {
+    cardKey: string
+    field: string
+    value: string | number
+}
+
 // One card; either in project or in template.
 export interface card {
     key: string
@@ -48,6 +55,23 @@ export interface card {
     parent?: string
     children?: card[]
     attachments?: attachmentDetails[]
+    calculations?: calculatedField[]
+    // Id of the calculation job that calculates the card, when calculated fields were not ready.
+    calculationJob?: number
+}
+
+// One card in card index; children are card keys.
+export interface cardIndexEntry {
+    key: string
+    path: string
+    parent: string
+    children: string[]
+}
+
+// Stored state of card index. Paths are relative to the indexed folder.
+export interface cardIndexState {
+    cards: { key: string, path: string, parent: string }[]
+    stamps: Record<string, number>
 }
 
 // When cards are listed using 'show cards'
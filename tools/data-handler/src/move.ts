@@ -4,6 +4,7 @@ import { join, sep } from 'node:path';
 // ismo
 import { copyDir, deleteDir } from './utils/file-utils.js';
 import { card } from './interfaces/project-interfaces.js';
+import { CardIndex } from './containers/card-index.js';
 import { Project } from './containers/project.js';
 
 export class Move {
@@ -46,7 +47,11 @@ export class Move {
         }
 
         const bothTemplateCards = Project.isTemplateCard(sourceCard) && Project.isTemplateCard(destinationCard);
-        const bothProjectCards = Move.project.hasCard(sourceCard.key) && Move.project.hasCard(destinationCard.key);
+        const [sourceInProject, destinationInProject] = await Promise.all([
+            Move.project.hasCard(sourceCard.key),
+            (destination === 'root') ? Promise.resolve(true) : Move.project.hasCard(destinationCard.key)
+        ]);
+        const bothProjectCards = sourceInProject && destinationInProject;
         if (!(bothTemplateCards || bothProjectCards)) {
             throw new Error(`Cards cannot be moved from project to template or vice versa`);
         }
@@ -57,5 +62,18 @@ export class Move {
 
         await copyDir(sourceCard.path, destinationPath);
         await deleteDir(sourceCard.path);
+
+        // Card can be moved between templates; then it moves from one card index to another.
+        const sourceIndex = CardIndex.owning(sourceCard.path);
+        const destinationIndex = (destination === 'root')
+            ? Move.project.cardIndex
+            : CardIndex.owning(destinationCard.path);
+        if (sourceIndex && sourceIndex !== destinationIndex) {
+            await sourceIndex.remove(sourceCard.key);
+        }
+        await destinationIndex?.move(
+            sourceCard.key,
+            destinationPath,
+            (destination === 'root') ? CardIndex.rootKey : destinationCard.key);
     }
 }
\ No newline at end of file
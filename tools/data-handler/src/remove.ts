@@ -4,7 +4,9 @@ import { join, sep } from 'node:path';
 
 // ismo
 import { Calculate } from './calculate.js';
+import { CardIndex } from './containers/card-index.js';
 import { deleteDir, deleteFile } from './utils/file-utils.js'
+import { ModuleRegistry } from './containers/module-registry.js';
 import { Project } from './containers/project.js';
 
 export class Remove extends EventEmitter {
@@ -58,6 +60,7 @@ export class Remove extends EventEmitter {
         await this.calculateCmd.handleDeleteCard(card);
       }
       await deleteDir(cardFolder);
+      await CardIndex.owning(cardFolder)?.remove(cardKey);
 
       if (card) {
         this.emit("removed", card);
@@ -71,6 +74,8 @@ export class Remove extends EventEmitter {
             throw new Error(`Module '${moduleName}' not found`);
         }
         await deleteDir(module);
+        CardIndex.invalidateFolder(module);
+        await ModuleRegistry.getInstance(Remove.project.modulesFolder).remove(moduleName);
     }
 
     // Removes template from project
@@ -88,6 +93,7 @@ export class Remove extends EventEmitter {
         }
 
         await deleteDir(templatePath);
+        CardIndex.invalidateFolder(templatePath);
     }
 
     /**
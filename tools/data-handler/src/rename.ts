@@ -6,6 +6,7 @@ import { rename, writeFile } from 'node:fs/promises';
 // ismo
 import { Calculate } from './calculate.js';
 import { card } from './interfaces/project-interfaces.js';
+import { CardIndex } from './containers/card-index.js';
 import { Project } from './containers/project.js';
 import { Template } from './containers/template.js';
 
@@ -19,7 +20,7 @@ export class Rename extends EventEmitter {
         this.calculateCmd = calculateCmd;
         this.addListener(
             'renamed',
-            this.calculateCmd.generate.bind(this.calculateCmd));
+            this.calculateCmd.handleProjectChanged.bind(this.calculateCmd));
     }
 
     // Sort cards by path length (so that renaming starts from children)
@@ -98,6 +99,9 @@ export class Rename extends EventEmitter {
             }
         }
 
+        // All card keys have changed; card indexes need to be re-built.
+        CardIndex.invalidateFolder(Rename.project.basePath);
+
         this.emit('renamed', Rename.project.basePath);
     }
 }
\ No newline at end of file
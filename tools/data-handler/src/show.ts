@@ -21,16 +21,13 @@ export class Show {
     public async showAttachments(projectPath: string): Promise<attachmentDetails[]> {
         Show.project = new Project(projectPath);
         const attachments: attachmentDetails[] = await Show.project.attachments();
-        const templateAttachments: attachmentDetails[] = [];
         const templates = await Show.project.templates();
-        for (const template of templates) {
+        const templateAttachments = await Promise.all(templates.map(async template => {
             const templateObject = await Show.project.createTemplateObject(template);
-            if (templateObject) {
-                templateAttachments.push(...await templateObject.attachments());
-            }
-        }
+            return templateObject ? templateObject.attachments() : [];
+        }));
 
-        attachments.push(...templateAttachments);
+        attachments.push(...templateAttachments.flat());
         return attachments;
     }
 
@@ -0,0 +1,98 @@
+// node
+import { createHash, randomUUID } from 'node:crypto';
+import { mkdir, readFile, rename, rm, writeFile } from 'node:fs/promises';
+import { join } from 'node:path';
+
+// Cached result of one card.
+interface cacheEntry<T> {
+    fingerprint: string
+    results: T
+}
+
+/**
+ * Caches calculation results of cards on disk. Each result is stored with the fingerprint of the
+ * inputs it was calculated from; a cached result is used only when the fingerprint still matches.
+ */
+export class CalculationCache {
+
+    private folder: string;
+
+    static folderName: string = 'results';
+
+    /**
+     * Creates calculation cache.
+     * @param {string} calculationFolder folder of the generated logic programs.
+     */
+    constructor(calculationFolder: string) {
+        this.folder = join(calculationFolder, CalculationCache.folderName);
+    }
+
+    // Returns cache file of a card.
+    private file(cardKey: string): string {
+        return join(this.folder, `${cardKey}.json`);
+    }
+
+    /**
+     * Removes all cached results.
+     */
+    public async clear() {
+        await rm(this.folder, { recursive: true, force: true });
+    }
+
+    /**
+     * Returns fingerprint of the given inputs.
+     * @param {string[]} inputs inputs of a calculation; the order matters.
+     * @returns fingerprint.
+     */
+    public static fingerprint(inputs: string[]): string {
+        const hash = createHash('sha256');
+        for (const input of inputs) {
+            hash.update(input);
+            hash.update('\0');
+        }
+        return hash.digest('hex');
+    }
+
+    /**
+     * Returns cached result of a card.
+     * @param {string} cardKey card key
+     * @param {string} fingerprint fingerprint of the current inputs
+     * @returns cached result, or undefined if there is no result for these inputs.
+     */
+    public async get<T>(cardKey: string, fingerprint: string): Promise<T | undefined> {
+        try {
+            const entry = JSON.parse(await readFile(this.file(cardKey), { encoding: 'utf-8' })) as cacheEntry<T>;
+            return entry.fingerprint === fingerprint ? entry.results : undefined;
+        } catch {
+            return undefined;
+        }
+    }
+
+    /**
+     * Removes cached results of cards.
+     * @param {string[]} cardKeys cards
+     * @returns cards that had a cached result.
+     */
+    public async remove(cardKeys: string[]): Promise<string[]> {
+        const removed = await Promise.all(cardKeys.map(cardKey =>
+            rm(this.file(cardKey)).then(() => cardKey, () => '')));
+        return removed.filter(cardKey => cardKey);
+    }
+
+    /**
+     * Stores result of a card.
+     * @param {string} cardKey card key
+     * @param {string} fingerprint fingerprint of the inputs that the result was calculated from
+     * @param {T} results result to store
+     */
+    public async set<T>(cardKey: string, fingerprint: string, results: T) {
+        const entry: cacheEntry<T> = { fingerprint: fingerprint, results: results };
+        const file = this.file(cardKey);
+        await mkdir(this.folder, { recursive: true });
+        // Write to a temporary file first, so that readers never see a partial entry.
+        // Same card can be calculated by parallel jobs; each of them has its own temporary file.
+        const temporaryFile = `${file}.${randomUUID()}.tmp`;
+        await writeFile(temporaryFile, JSON.stringify(entry), { encoding: 'utf-8' });
+        await rename(temporaryFile, file);
+    }
+}
@@ -0,0 +1,286 @@
+// node
+import { cpus } from 'node:os';
+import { resolve, sep } from 'node:path';
+
+/**
+ * State of a calculation job.
+ */
+export type calculationJobState = 'queued' | 'running' | 'done' | 'failed' | 'cancelled' | 'timeout';
+
+/**
+ * Status of a calculation job.
+ */
+export interface calculationJob {
+    id: number
+    name: string
+    scope: string
+    cardKey?: string
+    state: calculationJobState
+    queued: number
+    started?: number
+    finished?: number
+    error?: string
+}
+
+/**
+ * Options of a calculation job.
+ * 'delay' is the time in milliseconds that the job waits in the queue before it can be started;
+ * jobs queued after it that are ready can be started in the meantime.
+ * 'exclusive' jobs (e.g. generating the logic program) run alone; other jobs (e.g. queries) can
+ * run in parallel with each other.
+ * 'supersede' cancels earlier jobs with the same name in the same scope or in its sub-scopes.
+ * 'timeout' is in milliseconds; 0 means no timeout.
+ */
+export interface calculationJobOptions {
+    cardKey?: string
+    delay?: number
+    exclusive?: boolean
+    supersede?: boolean
+    timeout?: number
+}
+
+/**
+ * Queued calculation job; result is available once the job has finished.
+ */
+export interface queuedCalculationJob<T> {
+    job: calculationJob
+    result: Promise<T>
+}
+
+// Job in the queue.
+interface queueEntry {
+    status: calculationJob
+    controller: AbortController
+    exclusive: boolean
+    notBefore: number
+    timeout: number
+    run: (signal: AbortSignal) => Promise<unknown>
+    resolve: (value: unknown) => void
+    reject: (error: Error) => void
+    timer?: ReturnType<typeof setTimeout>
+}
+
+/**
+ * Runs calculation jobs of a project asynchronously. Jobs are started in the order they were
+ * queued, and at most 'concurrency' jobs run at a time. Each job has a timeout, and jobs can be
+ * cancelled. Status of recent jobs is kept, so that it can be polled.
+ */
+export class CalculationQueue {
+
+    private static instances: Map<string, CalculationQueue> = new Map();
+
+    private delayTimer?: ReturnType<typeof setTimeout>;
+    private finished: calculationJob[] = [];
+    private nextId: number = 0;
+    private queued: queueEntry[] = [];
+    private running: queueEntry[] = [];
+    private waiting: (() => void)[] = [];
+
+    static concurrency: number = Math.max(1, cpus().length);
+    static defaultTimeout: number = 60 * 1000;
+    static finishedJobsKept: number = 100;
+
+    // Finishes a job. Running job keeps its place until it has stopped.
+    private finish(entry: queueEntry, state: calculationJobState, error?: Error, value?: unknown) {
+        if (entry.status.finished !== undefined) {
+            return;
+        }
+        clearTimeout(entry.timer);
+        entry.status.state = state;
+        entry.status.finished = Date.now();
+        if (error) {
+            entry.status.error = error.message;
+        }
+        this.queued = this.queued.filter(item => item !== entry);
+        this.finished.push(entry.status);
+        this.finished.splice(0, Math.max(0, this.finished.length - CalculationQueue.finishedJobsKept));
+
+        if (state === 'done') {
+            entry.resolve(value);
+        } else {
+            entry.reject(error ?? new Error(`Calculation job ${entry.status.id} ${state}`));
+        }
+        this.startQueued();
+    }
+
+    // Returns true, if 'scope' is the same as 'parent' or inside it.
+    private static inScope(scope: string, parent: string): boolean {
+        return scope === parent || scope.startsWith(parent + sep);
+    }
+
+    // Starts a job.
+    private start(entry: queueEntry) {
+        this.queued = this.queued.filter(item => item !== entry);
+        this.running.push(entry);
+        entry.status.state = 'running';
+        entry.status.started = Date.now();
+        if (entry.timeout > 0) {
+            entry.timer = setTimeout(() => {
+                const error = new Error(`Calculation job ${entry.status.id} timed out after ${entry.timeout} ms`);
+                entry.controller.abort(error);
+                this.finish(entry, 'timeout', error);
+            }, entry.timeout);
+        }
+        entry.run(entry.controller.signal)
+            .then(value => this.finish(entry, 'done', undefined, value))
+            .catch(error => this.finish(entry, 'failed', error instanceof Error ? error : new Error(String(error))))
+            .finally(() => {
+                this.running = this.running.filter(item => item !== entry);
+                this.startQueued();
+            });
+    }
+
+    // Starts queued jobs in order while there is room. Exclusive jobs wait until no other
+    // job is running, and jobs queued after them wait for them. Delayed jobs are skipped until
+    // their delay has passed; jobs queued after them can start in the meantime.
+    private startQueued() {
+        clearTimeout(this.delayTimer);
+        this.delayTimer = undefined;
+        let nextStart: number | undefined = undefined;
+        for (const entry of [...this.queued]) {
+            if (entry.notBefore > Date.now()) {
+                nextStart = Math.min(nextStart ?? entry.notBefore, entry.notBefore);
+                continue;
+            }
+            const exclusiveRunning = this.running.some(item => item.exclusive);
+            if (exclusiveRunning ||
+                this.running.length >= CalculationQueue.concurrency ||
+                (entry.exclusive && this.running.length > 0)) {
+                break;
+            }
+            this.start(entry);
+        }
+        if (nextStart !== undefined) {
+            this.delayTimer = setTimeout(() => this.startQueued(), nextStart - Date.now());
+        }
+        if (this.queued.length === 0 && this.running.length === 0) {
+            const waiting = this.waiting;
+            this.waiting = [];
+            waiting.forEach(resolve => resolve());
+        }
+    }
+
+    /**
+     * Cancels a job.
+     * @param {number} id job id
+     * @returns true, if job was queued or running; false otherwise.
+     */
+    public cancel(id: number): boolean {
+        const entry = [...this.queued, ...this.running].find(item => item.status.id === id && item.status.finished === undefined);
+        if (!entry) {
+            return false;
+        }
+        const error = new Error(`Calculation job ${id} was cancelled`);
+        entry.controller.abort(error);
+        this.finish(entry, 'cancelled', error);
+        return true;
+    }
+
+    /**
+     * Queues a job.
+     * @param {string} name name of the job, e.g. 'generate'
+     * @param {string} scope path of the card tree that the job affects
+     * @param {function} run the job; should stop when 'signal' is aborted.
+     * @param {calculationJobOptions} options Optional, job options
+     * @returns job status and result.
+     */
+    public enqueue<T>(name: string, scope: string, run: (signal: AbortSignal) => Promise<T>, options: calculationJobOptions = {}): queuedCalculationJob<T> {
+        const scopePath = resolve(scope);
+        if (options.supersede) {
+            for (const entry of [...this.queued, ...this.running]) {
+                if (entry.status.name === name && CalculationQueue.inScope(entry.status.scope, scopePath)) {
+                    this.cancel(entry.status.id);
+                }
+            }
+        }
+
+        const status: calculationJob = {
+            id: ++this.nextId,
+            name: name,
+            scope: scopePath,
+            cardKey: options.cardKey,
+            state: 'queued',
+            queued: Date.now(),
+        };
+        const result = new Promise<T>((resolve, reject) => {
+            this.queued.push({
+                status: status,
+                controller: new AbortController(),
+                exclusive: options.exclusive === true,
+                notBefore: Date.now() + (options.delay ?? 0),
+                timeout: options.timeout ?? CalculationQueue.defaultTimeout,
+                run: run,
+                resolve: resolve as (value: unknown) => void,
+                reject: reject,
+            });
+        });
+        // Jobs are often queued without waiting for them; failures are reported in job status.
+        result.catch(() => {});
+        this.startQueued();
+        return { job: { ...status }, result: result };
+    }
+
+    /**
+     * Returns queue of a project. Instances are shared, so that all calculations of a project
+     * use the same queue.
+     * @param {string} projectPath path to the project
+     * @returns queue of the project.
+     */
+    public static getInstance(projectPath: string): CalculationQueue {
+        const path = resolve(projectPath);
+        let instance = CalculationQueue.instances.get(path);
+        if (!instance) {
+            instance = new CalculationQueue();
+            CalculationQueue.instances.set(path, instance);
+        }
+        return instance;
+    }
+
+    /**
+     * Returns when there are no queued or running jobs.
+     */
+    public async idle() {
+        if (this.queued.length === 0 && this.running.length === 0) {
+            return;
+        }
+        await new Promise<void>(resolve => this.waiting.push(resolve));
+    }
+
+    /**
+     * Returns status of a job.
+     * @param {number} id job id
+     * @returns job status, or undefined if job is not known.
+     */
+    public job(id: number): calculationJob | undefined {
+        return this.jobs().find(item => item.id === id);
+    }
+
+    /**
+     * Returns status of queued, running and recently finished jobs.
+     * @returns job statuses, oldest first.
+     */
+    public jobs(): calculationJob[] {
+        const active = [...this.running, ...this.queued]
+            .map(entry => entry.status)
+            .filter(item => item.finished === undefined);
+        return [...this.finished, ...active]
+            .map(item => ({ ...item }))
+            .sort((a, b) => a.id - b.id);
+    }
+
+    /**
+     * Postpones start of a queued job.
+     * @param {number} id job id
+     * @param {number} delay time in milliseconds from now, before which the job is not started.
+     * @returns true, if job was queued; false otherwise.
+     */
+    public postpone(id: number, delay: number): boolean {
+        const entry = this.queued.find(item => item.status.id === id);
+        if (!entry) {
+            return false;
+        }
+        entry.notBefore = Date.now() + delay;
+        this.startQueued();
+        return true;
+    }
+}
@@ -0,0 +1,698 @@
+// node
+import { spawn } from 'node:child_process';
+import { createHash, randomUUID } from 'node:crypto';
+import { createWriteStream, readFileSync } from 'node:fs';
+import { open, readFile, rename, rm, stat, writeFile } from 'node:fs/promises';
+import { Socket } from 'node:net';
+import { cpus } from 'node:os';
+import { dirname, join, resolve } from 'node:path';
+import { createInterface } from 'node:readline';
+import { pipeline } from 'node:stream/promises';
+
+// ismo
+import { pathExists } from './file-utils.js';
+
+/**
+ * Builds a query program. Query is added on top of the loaded base program, and it should only
+ * contain '#show' statements. Each '#show' statement must have 'guard' in its condition, so that
+ * the query can be switched off once it has been solved.
+ */
+export type clingoQuery = (guard: string) => string;
+
+/**
+ * Solver statistics of one clingo run. Times are in seconds. Grounding time is the time before
+ * solving started; it includes parsing and preprocessing, too. Peak memory (in bytes) is sampled
+ * while clingo runs, and it is known only on platforms that have '/proc' (e.g. Linux).
+ */
+export interface solverStatistics {
+    groundingTime: number
+    solvingTime: number
+    totalTime: number
+    rules: number
+    atoms: number
+    peakMemory?: number
+}
+
+// Answer of the solver worker to one query.
+interface workerResponse {
+    id?: number
+    ready?: boolean
+    error?: string
+    satisfiable?: boolean
+    symbols?: string[]
+}
+
+// Query that waits for an answer from the solver worker.
+interface pendingQuery {
+    resolve: (output: string) => void
+    reject: (error: Error) => void
+    onOutput?: (chunk: string) => void
+}
+
+// Files of the base program, and the stamp of the files that list them with '#include' statements.
+interface sourceList {
+    files: string[]
+    listing: string[]
+    listingStamp: string
+}
+
+// Solver worker; long-lived clingo process that has loaded and grounded the base program.
+interface solverWorker {
+    process: ReturnType<typeof spawn>
+    pending: Map<number, pendingQuery>
+    queries: number
+    stamp: string
+}
+
+/**
+ * Runs logic program queries with Clingo. In long-lived processes (see 'persistent'), base program
+ * ('main.lp' and the files it includes) is loaded and grounded once by long-lived clingo processes,
+ * which then get the queries over stdin. There is a pool of such workers, so that queries can be
+ * solved in parallel. Aborted query is interrupted; the worker goes on with the next query.
+ * The workers are driven by an embedded Python script, so they require clingo with Python support;
+ * if a worker cannot be started, or the process is short-lived (e.g. the CLI), each query is run
+ * with a new clingo process instead.
+ * Workers are restarted when the generated logic program files change.
+ * Base program can also be grounded ahead of time to a file (clingo's '--text' output); while the
+ * program files do not change, solving loads the grounded program instead of the base program.
+ * This reduces work rather than removes grounding: the ground rules are still parsed and passed
+ * through the grounder, but rules with variables are not instantiated again, which usually is the
+ * costly part. Only a worker, which keeps the grounded base program in memory, skips grounding.
+ */
+export class ClingoEngine {
+
+    private static instances: Map<string, ClingoEngine> = new Map();
+
+    private mainFile: string;
+    private nextId: number = 0;
+    private sources?: sourceList;
+    private starting?: Promise<solverWorker | undefined>;
+    private unavailableStamp?: string;
+    private workers: solverWorker[] = [];
+
+    static binaryName: string = 'clingo';
+    static groundFileName: string = 'ground.lp';
+    private static groundHeader: string = '% grounded from ';
+    // Worker releases each query part once it has been solved, but clingo cannot remove the parts;
+    // restart the worker after this many queries to limit memory use.
+    static maxWorkerQueries: number = 1000;
+    // Workers are started only when this is true. Set by long-lived sessions (e.g. the app server),
+    // where loading the base program once pays off; one-shot commands would only pay the start-up.
+    static persistent: boolean = false;
+    static poolSize: number = Math.max(1, cpus().length);
+    static workerFileName: string = 'engine.lp';
+    private static workerProgram: string = `
+#script (python)
+import json
+import sys
+import threading
+from clingo import Function, Number
+
+def main(ctl):
+    ctl.ground([("base", [])])
+    requests = []
+    cancelled = set()
+    condition = threading.Condition()
+
+    # Reads requests while queries are being solved; cancellations are noticed by the solving loop.
+    def read():
+        for line in sys.stdin:
+            request = json.loads(line)
+            with condition:
+                if "cancel" in request:
+                    cancelled.add(request["cancel"])
+                else:
+                    requests.append(request)
+                condition.notify()
+        with condition:
+            requests.append(None)
+            condition.notify()
+
+    def is_cancelled(id):
+        with condition:
+            return id in cancelled
+
+    threading.Thread(target=read, daemon=True).start()
+    print(json.dumps({"ready": True}), flush=True)
+    while True:
+        with condition:
+            condition.wait_for(lambda: len(requests) > 0)
+            request = requests.pop(0)
+        if request is None:
+            break
+        id = request["id"]
+        guard = Function("query", [Number(id)])
+        part = "query_" + str(id)
+        grounded = False
+        try:
+            if is_cancelled(id):
+                raise RuntimeError("query was cancelled")
+            ctl.add(part, [], request["program"])
+            ctl.ground([(part, [])])
+            grounded = True
+            ctl.assign_external(guard, True)
+            symbols = []
+            def on_model(model):
+                symbols[:] = [str(symbol) for symbol in model.symbols(shown=True)]
+            with ctl.solve(on_model=on_model, async_=True) as handle:
+                while not handle.wait(0.05):
+                    if is_cancelled(id):
+                        handle.cancel()
+                result = handle.get()
+            if result.interrupted:
+                raise RuntimeError("query was cancelled")
+            print(json.dumps({"id": id, "symbols": symbols, "satisfiable": result.satisfiable}), flush=True)
+        except Exception as error:
+            print(json.dumps({"id": id, "error": str(error)}), flush=True)
+        finally:
+            # Released query is false from now on; cleanup drops what was grounded for it.
+            if grounded:
+                ctl.release_external(guard)
+                ctl.cleanup()
+            with condition:
+                cancelled.difference_update([item for item in cancelled if item <= id])
+#end.
+`;
+
+    constructor(mainFile: string) {
+        this.mainFile = resolve(mainFile);
+    }
+
+    // Returns a worker that has loaded the current base program.
+    private async currentWorker(): Promise<solverWorker | undefined> {
+        if (!ClingoEngine.persistent) {
+            return undefined;
+        }
+        while (this.starting) {
+            await this.starting;
+        }
+        const stamp = await this.sourcesStamp();
+        if (stamp === this.unavailableStamp || !pathExists(this.mainFile)) {
+            // Worker could not load this version of the program; errors are reported by the one-time process.
+            return undefined;
+        }
+        for (const worker of this.workers.filter(item => item.stamp !== stamp || item.queries >= ClingoEngine.maxWorkerQueries)) {
+            this.retireWorker(worker);
+        }
+        const idle = this.workers.find(worker => worker.pending.size === 0);
+        if (idle || this.workers.length >= ClingoEngine.poolSize) {
+            return idle ?? this.workers.reduce((least, worker) => worker.pending.size < least.pending.size ? worker : least);
+        }
+
+        this.starting = this.startWorker(stamp);
+        let started: solverWorker | undefined;
+        try {
+            started = await this.starting;
+        } finally {
+            this.starting = undefined;
+        }
+        if (started) {
+            this.workers.push(started);
+        }
+        this.unavailableStamp = started || this.workers.length > 0 ? undefined : stamp;
+        return started ?? this.workers.at(0);
+    }
+
+    // Ends the worker; queries that are waiting for it fail.
+    private endWorker(worker: solverWorker, error: Error) {
+        this.workers = this.workers.filter(item => item !== worker);
+        for (const query of worker.pending.values()) {
+            query.reject(error);
+        }
+        worker.pending.clear();
+        worker.process.stdin?.end();
+        worker.process.kill();
+    }
+
+    // Returns true, if clingo exit code tells that the run failed. Exit codes are bitfields;
+    // only 10 (satisfiable) and 20 (search space exhausted) are not failures.
+    private static failed(code: number | null): boolean {
+        return code === null || (code & ~(10 | 20)) !== 0;
+    }
+
+    // Returns the file of the grounded base program.
+    private groundFile(): string {
+        return join(dirname(this.mainFile), ClingoEngine.groundFileName);
+    }
+
+    // Returns the header line of the grounded program; it identifies the program files it was grounded from.
+    private static groundHeaderLine(stamp: string): string {
+        return `${ClingoEngine.groundHeader}${createHash('sha256').update(stamp).digest('hex')}\n`;
+    }
+
+    // Handles one line of worker output.
+    private handleResponse(worker: solverWorker, line: string) {
+        let response: workerResponse;
+        try {
+            response = JSON.parse(line);
+        } catch {
+            // Not an answer (e.g. output of a calculation program); ignore it.
+            return;
+        }
+        const query = response.id !== undefined ? worker.pending.get(response.id) : undefined;
+        if (!query || response.id === undefined) {
+            return;
+        }
+        worker.pending.delete(response.id);
+        this.queryDone(worker);
+        if (response.error !== undefined) {
+            query.reject(new Error(`Clingo error: ${response.error}`));
+            return;
+        }
+        const status = response.satisfiable ? 'SATISFIABLE' : 'UNSATISFIABLE';
+        if (query.onOutput) {
+            for (const symbol of response.symbols ?? []) {
+                query.onOutput(`${symbol}\n`);
+            }
+            query.onOutput(status);
+            query.resolve('');
+        } else {
+            query.resolve([...response.symbols ?? [], status].join('\n'));
+        }
+    }
+
+    // Keeps the Node process alive only while the worker has queries to answer.
+    private keepAlive(worker: solverWorker) {
+        const streams = [worker.process.stdin, worker.process.stdout] as (Socket | null)[];
+        if (worker.pending.size > 0) {
+            worker.process.ref();
+            streams.forEach(stream => stream?.ref());
+        } else {
+            worker.process.unref();
+            streams.forEach(stream => stream?.unref());
+        }
+    }
+
+    // Logs the reasons of a failed clingo run. Clingo's exit codes are bitfields.
+    private static logExitCode(code: number) {
+        const clingo_process_exit = {
+            E_UNKNOWN: 0,
+            E_INTERRUPT: 1,
+            E_SAT: 10,
+            E_EXHAUST: 20,
+            E_MEMORY: 33,
+            E_ERROR: 65,
+            E_NO_RUN: 128,
+        };
+        // "satisfied" && "exhaust" mean that everything was inspected and a solution was found.
+        if (!((code & clingo_process_exit.E_SAT) && (code & clingo_process_exit.E_EXHAUST))) {
+            if (code & clingo_process_exit.E_ERROR) {
+                console.error('Error');
+            }
+            if (code & clingo_process_exit.E_INTERRUPT) {
+                console.error('Interrupted');
+            }
+            if (code & clingo_process_exit.E_MEMORY) {
+                console.error('Out of memory');
+            }
+            if (code & clingo_process_exit.E_NO_RUN) {
+                console.error('Not run');
+            }
+            if (code & clingo_process_exit.E_UNKNOWN) {
+                console.error('Unknown error');
+            }
+        }
+    }
+
+    // Error when clingo cannot be run.
+    private static notFoundError(): Error {
+        return new Error('Cannot find "Clingo". Please install "Clingo".\nIf using MacOs: "brew install clingo".\nIf using Windows: download sources and compile new version.\nIf using Linux: check if your distribution contains pre-built package. Otherwise download sources and compile.');
+    }
+
+    // Parses statistics that clingo prints with '--stats'. Only top level lines are read,
+    // e.g. 'Time : 0.010s (Solving: 0.00s ...)' and 'Rules : 42'.
+    private static parseStatistics(output: string): solverStatistics {
+        const values: Map<string, string> = new Map();
+        for (const line of output.split('\n')) {
+            const match = line.match(/^(\S[^:]*?)\s*:\s*(.*)$/);
+            if (match) {
+                values.set(match[1], match[2]);
+            }
+        }
+        const number = (text: string | undefined) => {
+            const value = parseFloat(text ?? '');
+            return isNaN(value) ? 0 : value;
+        };
+        const time = values.get('Time');
+        const totalTime = number(time);
+        const solvingTime = number(time?.match(/Solving:\s*([0-9.]+)/)?.[1]);
+        return {
+            groundingTime: Math.max(0, totalTime - solvingTime),
+            solvingTime: solvingTime,
+            totalTime: totalTime,
+            rules: number(values.get('Rules')),
+            atoms: number(values.get('Atoms')),
+        };
+    }
+
+    // Returns the highest memory use of a process so far, in bytes; undefined, if it is not known.
+    private static peakMemory(pid: number | undefined): number | undefined {
+        try {
+            const status = readFileSync(`/proc/${pid}/status`, { encoding: 'utf-8' });
+            const kilobytes = status.match(/^VmHWM:\s*(\d+)\s*kB/m)?.[1];
+            return kilobytes ? Number(kilobytes) * 1024 : undefined;
+        } catch {
+            return undefined;
+        }
+    }
+
+    // Returns the base program file to load: the grounded program, if it has been grounded from
+    // the current program files, otherwise the main file.
+    private async programFile(stamp: string): Promise<string> {
+        const header = ClingoEngine.groundHeaderLine(stamp);
+        const buffer = Buffer.alloc(header.length);
+        let read = 0;
+        try {
+            const file = await open(this.groundFile(), 'r');
+            try {
+                read = (await file.read(buffer, 0, buffer.length, 0)).bytesRead;
+            } finally {
+                await file.close();
+            }
+        } catch {
+            return this.mainFile;
+        }
+        return buffer.toString('utf-8', 0, read) === header ? this.groundFile() : this.mainFile;
+    }
+
+    // Called when the worker no longer waits for a query. Replaced worker is ended once it has
+    // no queries left; otherwise the worker keeps the Node process alive only while it has queries.
+    private queryDone(worker: solverWorker) {
+        if (!this.workers.includes(worker) && worker.pending.size === 0) {
+            this.endWorker(worker, new Error('Clingo error: solver restarted'));
+        } else {
+            this.keepAlive(worker);
+        }
+    }
+
+    // Takes the worker out of use; it is ended once it has answered its queries.
+    private retireWorker(worker: solverWorker) {
+        if (worker.pending.size === 0) {
+            this.endWorker(worker, new Error('Clingo error: solver restarted'));
+        } else {
+            this.workers = this.workers.filter(item => item !== worker);
+        }
+    }
+
+    // Runs a query with a new clingo process.
+    private async solveWithProcess(query: clingoQuery, signal?: AbortSignal, onOutput?: (chunk: string) => void): Promise<string> {
+        const text = `query.\n${query('query')}`;
+        const programFile = await this.programFile(await this.sourcesStamp());
+        return new Promise((resolve, reject) => {
+            const clingo = spawn(ClingoEngine.binaryName, ['-', '--outf=0', '--out-ifs=\\n', '-V0', programFile], { signal: signal });
+            let output = false;
+            let stdout = '';
+            let stderr = '';
+            let settled = false;
+            const settle = (error?: Error) => {
+                if (settled) {
+                    return;
+                }
+                settled = true;
+                if (error) {
+                    reject(error);
+                } else {
+                    resolve(stdout);
+                }
+            };
+
+            // Decoded as text, so that a chunk never ends in the middle of a character.
+            clingo.stdout.setEncoding('utf-8');
+            clingo.stdout.on('data', (data: string) => {
+                output = true;
+                if (onOutput) {
+                    onOutput(data);
+                } else {
+                    stdout += data;
+                }
+            });
+            clingo.stderr.on('data', data => stderr += data);
+            clingo.stdin.on('error', () => { /* reported through 'error' or 'close' */ });
+            clingo.on('error', error => settle(error.name === 'AbortError' ? error : ClingoEngine.notFoundError()));
+            clingo.on('close', code => {
+                if (output) {
+                    settle();
+                } else if (stderr && code) {
+                    ClingoEngine.logExitCode(code);
+                    settle(new Error('Clingo error'));
+                } else {
+                    settle(ClingoEngine.notFoundError());
+                }
+            });
+            clingo.stdin.end(text);
+        });
+    }
+
+    // Runs a query with the solver worker.
+    private solveWithWorker(worker: solverWorker, query: clingoQuery, signal?: AbortSignal, onOutput?: (chunk: string) => void): Promise<string> {
+        const id = ++this.nextId;
+        const guard = `query(${id})`;
+        const program = `#external ${guard}.\n${query(guard)}`;
+        worker.queries++;
+        return new Promise((resolve, reject) => {
+            const abort = () => {
+                const pending = worker.pending.get(id);
+                if (pending) {
+                    // Worker interrupts the query; its answer is ignored.
+                    worker.pending.delete(id);
+                    pending.reject(new Error('Clingo error: query was aborted'));
+                    worker.process.stdin?.write(`${JSON.stringify({ cancel: id })}\n`);
+                    this.queryDone(worker);
+                }
+            };
+            worker.pending.set(id, {
+                resolve: output => { signal?.removeEventListener('abort', abort); resolve(output); },
+                reject: error => { signal?.removeEventListener('abort', abort); reject(error); },
+                onOutput: onOutput,
+            });
+            if (signal?.aborted) {
+                abort();
+                return;
+            }
+            signal?.addEventListener('abort', abort);
+            this.keepAlive(worker);
+            worker.process.stdin?.write(`${JSON.stringify({ id: id, program: program })}\n`);
+        });
+    }
+
+    // Returns files of the base program; main file, the files it includes and the files that they include.
+    // Only the main file and the files it includes directly have '#include' statements (e.g. the list of
+    // fact shards and modules). They are read again only when they have changed; other files are not read.
+    private async sourceFiles(): Promise<string[]> {
+        const listingStamp = this.sources ? await ClingoEngine.stamp(this.sources.listing) : '';
+        if (this.sources && this.sources.listingStamp === listingStamp) {
+            return this.sources.files;
+        }
+        const includes = async (file: string) => {
+            const content = await readFile(file, { encoding: 'utf-8' }).catch(() => '');
+            return [...content.matchAll(/#include\s+"([^"]+)"/g)].map(match => resolve(dirname(file), match[1]));
+        };
+        const listing = [this.mainFile, ...await includes(this.mainFile)];
+        // Stamp is taken before reading, so that a change during reading is noticed on next call.
+        const stamp = await ClingoEngine.stamp(listing);
+        const included = (await Promise.all(listing.slice(1).map(file => includes(file)))).flat();
+        this.sources = { files: [...listing, ...included], listing: listing, listingStamp: stamp };
+        return this.sources.files;
+    }
+
+    // Returns a stamp that changes when any of the base program files change.
+    private async sourcesStamp(): Promise<string> {
+        return ClingoEngine.stamp(await this.sourceFiles());
+    }
+
+    // Returns a stamp that changes when any of the files change. Files are only stat'd, not read.
+    private static async stamp(files: string[]): Promise<string> {
+        const stamps = await Promise.all(files.map(async file => {
+            const stats = await stat(file).catch(() => undefined);
+            return stats ? `${file}:${stats.mtimeMs}:${stats.size}` : `${file}:-`;
+        }));
+        return stamps.join('|');
+    }
+
+    // Starts the solver worker. Returns undefined, if the worker cannot be started.
+    private async startWorker(stamp: string): Promise<solverWorker | undefined> {
+        const workerFile = join(dirname(this.mainFile), ClingoEngine.workerFileName);
+        try {
+            await writeFile(workerFile, ClingoEngine.workerProgram, { encoding: 'utf-8' });
+        } catch {
+            return undefined;
+        }
+        const programFile = await this.programFile(stamp);
+
+        return new Promise(resolveStart => {
+            const child = spawn(ClingoEngine.binaryName, ['--outf=3', '-V0', workerFile, programFile], { stdio: ['pipe', 'pipe', 'pipe'] });
+            const worker: solverWorker = { process: child, pending: new Map(), queries: 0, stamp: stamp };
+            let ready = false;
+            let errorOutput = '';
+
+            const fail = (error: Error) => {
+                if (!ready) {
+                    ready = true;
+                    child.kill();
+                    resolveStart(undefined);
+                    return;
+                }
+                this.endWorker(worker, error);
+            };
+
+            child.on('error', error => fail(error));
+            child.on('exit', () => fail(new Error(`Clingo error: ${errorOutput.trim() || 'solver exited'}`)));
+            child.stderr?.on('data', data => {
+                // Keep only the latest messages.
+                errorOutput = (errorOutput + data).slice(-4096);
+            });
+            child.stdin?.on('error', () => { /* reported through 'exit' */ });
+            createInterface({ input: child.stdout! }).on('line', line => {
+                if (!ready) {
+                    if (line.includes('"ready"')) {
+                        ready = true;
+                        this.keepAlive(worker);
+                        resolveStart(worker);
+                    }
+                    return;
+                }
+                this.handleResponse(worker, line);
+            });
+            (child.stderr as Socket | null)?.unref();
+        });
+    }
+
+    /**
+     * Stops the solver worker.
+     */
+    public close() {
+        for (const worker of this.workers) {
+            this.endWorker(worker, new Error('Clingo error: solver closed'));
+        }
+    }
+
+    /**
+     * Returns engine of a logic program. Instances are shared, so that the base program is
+     * loaded only once.
+     * @param {string} mainFile path to the main logic program file.
+     * @returns engine of the program.
+     */
+    public static getInstance(mainFile: string): ClingoEngine {
+        const path = resolve(mainFile);
+        let instance = ClingoEngine.instances.get(path);
+        if (!instance) {
+            instance = new ClingoEngine(path);
+            ClingoEngine.instances.set(path, instance);
+        }
+        return instance;
+    }
+
+    /**
+     * Grounds the base program and stores it as text, so that later queries do not need to
+     * instantiate the rules again; they still parse the ground rules. Grounded program is used
+     * until the program files change.
+     * @param {AbortSignal} signal Optional, aborts grounding.
+     */
+    public async ground(signal?: AbortSignal) {
+        // Stamp is taken before grounding; if files change meanwhile, the result is outdated right away.
+        const stamp = await this.sourcesStamp();
+        const file = this.groundFile();
+        const temporaryFile = `${file}.${randomUUID()}.tmp`;
+        const output = createWriteStream(temporaryFile, { encoding: 'utf-8' });
+        output.write(ClingoEngine.groundHeaderLine(stamp));
+
+        const clingo = spawn(ClingoEngine.binaryName, ['--mode=gringo', '--text', this.mainFile], { signal: signal });
+        let stderr = '';
+        clingo.stderr.on('data', data => stderr += data);
+        const exit = new Promise<number | null>((resolve, reject) => {
+            clingo.on('error', error => reject(error.name === 'AbortError' ? error : ClingoEngine.notFoundError()));
+            clingo.on('close', code => resolve(code));
+        });
+        try {
+            const [code] = await Promise.all([exit, pipeline(clingo.stdout, output)]);
+            if (ClingoEngine.failed(code)) {
+                throw new Error(`Clingo error: ${stderr.trim() || 'grounding failed'}`);
+            }
+            await rename(temporaryFile, file);
+        } catch (error) {
+            output.destroy();
+            await rm(temporaryFile, { force: true });
+            throw error;
+        }
+    }
+
+    /**
+     * Checks if the base program has been grounded from the current program files.
+     * @returns true, if queries can use the grounded program.
+     */
+    public async grounded(): Promise<boolean> {
+        return await this.programFile(await this.sourcesStamp()) !== this.mainFile;
+    }
+
+    /**
+     * Marks the loaded base program outdated. Workers are restarted on next query, and the list
+     * of program files is read again.
+     */
+    public invalidate() {
+        this.sources = undefined;
+        for (const worker of this.workers) {
+            worker.stamp = '';
+        }
+    }
+
+    /**
+     * Runs a query with a new clingo process, and returns the solver statistics of the run.
+     * Base program is always grounded, so that grounding is included in the statistics.
+     * @param {string[]} files logic program files to load instead of the whole base program,
+     *                         e.g. to measure the cost of one module. If empty, main file is loaded.
+     * @param {clingoQuery} query builds the query program.
+     * @param {AbortSignal} signal Optional, aborts the run.
+     * @returns solver statistics.
+     */
+    public profile(files: string[], query: clingoQuery, signal?: AbortSignal): Promise<solverStatistics> {
+        const text = `query.\n${query('query')}`;
+        const programFiles = files.length > 0 ? files : [this.mainFile];
+        return new Promise((resolve, reject) => {
+            const clingo = spawn(ClingoEngine.binaryName, ['-', '--stats', '--quiet=2', ...programFiles], { signal: signal });
+            let peakMemory: number | undefined;
+            const sample = () => {
+                peakMemory = ClingoEngine.peakMemory(clingo.pid) ?? peakMemory;
+            };
+            const sampler = setInterval(sample, 10);
+            let stdout = '';
+            let stderr = '';
+            clingo.stdout.setEncoding('utf-8');
+            clingo.stdout.on('data', (data: string) => {
+                stdout += data;
+                // Statistics are printed last; take the last sample before the process ends.
+                sample();
+            });
+            clingo.stderr.on('data', data => stderr += data);
+            clingo.stdin.on('error', () => { /* reported through 'error' or 'close' */ });
+            clingo.on('error', error => {
+                clearInterval(sampler);
+                reject(error.name === 'AbortError' ? error : ClingoEngine.notFoundError());
+            });
+            clingo.on('close', code => {
+                clearInterval(sampler);
+                if (!stdout) {
+                    reject(stderr ? new Error(`Clingo error: ${stderr.trim()}`) : ClingoEngine.notFoundError());
+                } else if (ClingoEngine.failed(code)) {
+                    reject(new Error(`Clingo error: ${stderr.trim() || 'solving failed'}`));
+                } else {
+                    resolve({ ...ClingoEngine.parseStatistics(stdout), peakMemory: peakMemory });
+                }
+            });
+            clingo.stdin.end(text);
+        });
+    }
+
+    /**
+     * Runs a query.
+     * @param {clingoQuery} query builds the query program.
+     * @param {AbortSignal} signal Optional, aborts the query.
+     * @param {function} onOutput Optional, gets the output in pieces as it arrives; then the output is not collected.
+     * @returns clingo output; shown atoms, one per line, followed by solving result. Empty, if 'onOutput' is given.
+     */
+    public async solve(query: clingoQuery, signal?: AbortSignal, onOutput?: (chunk: string) => void): Promise<string> {
+        const worker = await this.currentWorker();
+        return worker
+            ? this.solveWithWorker(worker, query, signal, onOutput)
+            : this.solveWithProcess(query, signal, onOutput);
+    }
+}
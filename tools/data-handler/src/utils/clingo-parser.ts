@@ -0,0 +1,151 @@
+/**
+ * Term in clingo output: a number, a string, or a function. Constants (e.g. card keys) are
+ * functions without arguments, and tuples are functions without a name.
+ */
+export type clingoTerm = number | string | clingoFunction;
+
+/**
+ * Function term in clingo output, e.g. 'field(decision_5, "summary", "text")'.
+ */
+export interface clingoFunction {
+    name: string
+    args: clingoTerm[]
+}
+
+/**
+ * Result of solving, as reported by clingo after the shown atoms.
+ */
+export type clingoStatus = 'SATISFIABLE' | 'UNSATISFIABLE' | 'UNKNOWN' | 'OPTIMUM FOUND' | '';
+
+// Function whose arguments are being read.
+interface openFunction {
+    name: string
+    args: clingoTerm[]
+}
+
+/**
+ * Parses clingo's text output incrementally. Output can be given in chunks of any size; each
+ * shown atom is passed to the callback as soon as it is complete, so the whole output is never
+ * kept in memory. Strings are unescaped, and numbers are returned as numbers.
+ */
+export class ClingoOutputParser {
+
+    private escape: boolean = false;
+    private inString: boolean = false;
+    private onSymbol: (symbol: clingoFunction) => void;
+    private stack: openFunction[] = [];
+    private status: clingoStatus = '';
+    private text: string = '';
+    private token: string = '';
+
+    private static statusWords: string[] = ['SATISFIABLE', 'UNSATISFIABLE', 'UNKNOWN', 'OPTIMUM', 'FOUND'];
+    private static tokenCharacter: RegExp = /[A-Za-z0-9_'#-]/;
+
+    /**
+     * Creates parser.
+     * @param {function} onSymbol called with each shown atom.
+     */
+    constructor(onSymbol: (symbol: clingoFunction) => void) {
+        this.onSymbol = onSymbol;
+    }
+
+    // Adds a complete term to the open function, or handles it as a top level atom.
+    private addTerm(term: clingoTerm) {
+        const parent = this.stack.at(-1);
+        if (parent) {
+            parent.args.push(term);
+        } else if (typeof term !== 'object') {
+            // Top level numbers and strings are not atoms.
+            return;
+        } else if (term.args.length === 0 && ClingoOutputParser.statusWords.includes(term.name)) {
+            // 'OPTIMUM FOUND' is two words.
+            this.status = term.name === 'OPTIMUM' || term.name === 'FOUND' ? 'OPTIMUM FOUND' : term.name as clingoStatus;
+        } else {
+            this.onSymbol(term);
+        }
+    }
+
+    // Completes the number or constant that has been read.
+    private endToken() {
+        if (!this.token) {
+            return;
+        }
+        const token = this.token;
+        this.token = '';
+        this.addTerm(/^-?[0-9]+$/.test(token) ? Number(token) : { name: token, args: [] });
+    }
+
+    // Reads one character outside of strings.
+    private readCharacter(character: string) {
+        if (ClingoOutputParser.tokenCharacter.test(character)) {
+            this.token += character;
+        } else if (character === '(') {
+            // Name is right before the parenthesis; tuples do not have a name.
+            this.stack.push({ name: this.token, args: [] });
+            this.token = '';
+        } else if (character === ')') {
+            this.endToken();
+            const closed = this.stack.pop();
+            if (closed) {
+                this.addTerm(closed);
+            }
+        } else if (character === '"') {
+            this.endToken();
+            this.inString = true;
+        } else {
+            // Whitespace and commas separate terms.
+            this.endToken();
+        }
+    }
+
+    /**
+     * Ends parsing; the last atom is completed.
+     * @returns solving result, or empty string if the output did not contain it.
+     */
+    public end(): clingoStatus {
+        this.endToken();
+        return this.status;
+    }
+
+    /**
+     * Returns a term as text, in the same format as clingo shows it.
+     * @param {clingoTerm} term term
+     * @returns term as text.
+     */
+    public static text(term: clingoTerm): string {
+        if (typeof term === 'number') {
+            return String(term);
+        }
+        if (typeof term === 'string') {
+            return `"${term.replace(/\\/g, '\\\\').replace(/"/g, '\\"').replace(/\n/g, '\\n')}"`;
+        }
+        if (term.args.length === 0 && term.name) {
+            return term.name;
+        }
+        return `${term.name}(${term.args.map(arg => ClingoOutputParser.text(arg)).join(',')})`;
+    }
+
+    /**
+     * Parses a piece of output.
+     * @param {string} chunk output; can end in the middle of an atom.
+     */
+    public write(chunk: string) {
+        for (const character of chunk) {
+            if (!this.inString) {
+                this.readCharacter(character);
+            } else if (this.escape) {
+                this.text += character === 'n' ? '\n' : character;
+                this.escape = false;
+            } else if (character === '\\') {
+                this.escape = true;
+            } else if (character === '"') {
+                const text = this.text;
+                this.text = '';
+                this.inString = false;
+                this.addTerm(text);
+            } else {
+                this.text += character;
+            }
+        }
+    }
+}
@@ -0,0 +1,232 @@
+// node
+import { createHash } from 'node:crypto';
+import type { FileHandle } from 'node:fs/promises';
+import { mkdir, open, readdir, readFile, rename, rm, writeFile } from 'node:fs/promises';
+import { join } from 'node:path';
+
+/**
+ * Stores logic program facts of cards in a few shard files, instead of one file per card.
+ * Cards are divided to shards by their key. In a shard, facts of each card are in their own block,
+ * which starts with a header line. Blocks can be replaced in place, so that changing some cards
+ * rewrites only the shards that contain them.
+ */
+export class FactStore {
+
+    private folder: string;
+
+    static folderName: string = 'facts';
+    static shardCount: number = 16;
+    private static blockHeader: string = '%% card ';
+    // Facts of a shard are written to file in pieces of about this many characters.
+    private static flushSize: number = 64 * 1024;
+
+    /**
+     * Creates fact store.
+     * @param {string} calculationFolder folder of the generated logic programs.
+     */
+    constructor(calculationFolder: string) {
+        this.folder = join(calculationFolder, FactStore.folderName);
+    }
+
+    // Returns block of a card in a shard file.
+    private static block(key: string, facts: string): string {
+        return `${FactStore.blockHeader}${key}\n${facts}${facts ? '\n' : ''}`;
+    }
+
+    // Groups cards by shard.
+    private static byShard<T>(keys: Iterable<[string, T]>): Map<number, Map<string, T>> {
+        const shards: Map<number, Map<string, T>> = new Map();
+        for (const [key, value] of keys) {
+            const shard = FactStore.shardOf(key);
+            let cards = shards.get(shard);
+            if (!cards) {
+                cards = new Map();
+                shards.set(shard, cards);
+            }
+            cards.set(key, value);
+        }
+        return shards;
+    }
+
+    // Reads blocks of a shard.
+    private async readShard(shard: number): Promise<Map<string, string>> {
+        const blocks: Map<string, string> = new Map();
+        let content = '';
+        try {
+            content = await readFile(join(this.folder, FactStore.shardFile(shard)), { encoding: 'utf-8' });
+        } catch {
+            return blocks;
+        }
+        let key = '';
+        let facts: string[] = [];
+        for (const line of content.split('\n')) {
+            if (line.startsWith(FactStore.blockHeader)) {
+                if (key) {
+                    blocks.set(key, facts.join('\n'));
+                }
+                key = line.substring(FactStore.blockHeader.length);
+                facts = [];
+            } else if (key && line) {
+                facts.push(line);
+            }
+        }
+        if (key) {
+            blocks.set(key, facts.join('\n'));
+        }
+        return blocks;
+    }
+
+    // Returns file name of a shard.
+    private static shardFile(shard: number): string {
+        return `shard-${String(shard).padStart(2, '0')}.lp`;
+    }
+
+    // Returns shard of a card.
+    private static shardOf(cardKey: string): number {
+        // FNV-1a hash; the same key always goes to the same shard.
+        let hash = 0x811c9dc5;
+        for (let index = 0; index < cardKey.length; index++) {
+            hash ^= cardKey.charCodeAt(index);
+            hash = Math.imul(hash, 0x01000193) >>> 0;
+        }
+        return hash % FactStore.shardCount;
+    }
+
+    // Writes blocks of a shard.
+    private async writeShard(shard: number, blocks: Map<string, string>) {
+        let content = '';
+        for (const [key, facts] of blocks) {
+            content += FactStore.block(key, facts);
+        }
+        // Write to a temporary file first, so that solver never reads a partial shard.
+        const file = join(this.folder, FactStore.shardFile(shard));
+        await writeFile(`${file}.tmp`, content, { encoding: 'utf-8' });
+        await rename(`${file}.tmp`, file);
+    }
+
+    /**
+     * Returns facts of cards.
+     * @param {string[]} cardKeys cards
+     * @returns facts of each card; cards that do not have facts are not included.
+     */
+    public async facts(cardKeys: string[]): Promise<Map<string, string>> {
+        const facts: Map<string, string> = new Map();
+        const shards = FactStore.byShard(cardKeys.map(key => [key, true]));
+        await Promise.all([...shards].map(async ([shard, cards]) => {
+            const blocks = await this.readShard(shard);
+            for (const key of cards.keys()) {
+                const block = blocks.get(key);
+                if (block !== undefined) {
+                    facts.set(key, block);
+                }
+            }
+        }));
+        return facts;
+    }
+
+    /**
+     * Returns the files that the logic program should include; relative to calculation folder.
+     * @returns shard files.
+     */
+    public files(): string[] {
+        return Array.from({ length: FactStore.shardCount }, (_, shard) => `${FactStore.folderName}/${FactStore.shardFile(shard)}`);
+    }
+
+    /**
+     * Returns fingerprint of the facts of all cards.
+     * @returns hash of the content of all shards.
+     */
+    public async fingerprint(): Promise<string> {
+        const contents = await Promise.all(Array.from({ length: FactStore.shardCount }, (_, shard) =>
+            readFile(join(this.folder, FactStore.shardFile(shard)), { encoding: 'utf-8' }).catch(() => '')));
+        const hash = createHash('sha256');
+        for (const content of contents) {
+            hash.update(content);
+            hash.update('\0');
+        }
+        return hash.digest('hex');
+    }
+
+    /**
+     * Removes facts of cards. Each shard is rewritten at most once, and only if it had
+     * facts of some of the cards.
+     * @param {string[]} cardKeys cards to remove.
+     */
+    public async remove(cardKeys: string[]) {
+        await mkdir(this.folder, { recursive: true });
+        const shards = FactStore.byShard(cardKeys.map(key => [key, true]));
+        await Promise.all([...shards].map(async ([shard, cards]) => {
+            const blocks = await this.readShard(shard);
+            let removed = false;
+            for (const key of cards.keys()) {
+                removed = blocks.delete(key) || removed;
+            }
+            if (removed) {
+                await this.writeShard(shard, blocks);
+            }
+        }));
+    }
+
+    /**
+     * Replaces all facts. Shards that would be empty are written as well, so that all of them
+     * can be included in the logic program.
+     * @param {Map<string, string>} facts facts of each card.
+     */
+    public async replaceAll(facts: Map<string, string>) {
+        await this.replaceAllFrom((async function* () { yield* facts; })());
+    }
+
+    /**
+     * Replaces all facts with facts that are given card by card. Facts are appended to temporary
+     * shard files as they arrive, so that facts of all cards are never in memory at once. Shards are
+     * replaced only after all facts have been written; if the facts cannot be read, current shards are kept.
+     * @param {AsyncIterable<[string, string]>} facts facts of each card, as [card key, facts] pairs.
+     */
+    public async replaceAllFrom(facts: AsyncIterable<[string, string]>) {
+        await mkdir(this.folder, { recursive: true });
+        const files = Array.from({ length: FactStore.shardCount }, (_, shard) => join(this.folder, FactStore.shardFile(shard)));
+        const buffers: string[] = files.map(() => '');
+        const handles: FileHandle[] = [];
+        try {
+            for (const file of files) {
+                handles.push(await open(`${file}.tmp`, 'w'));
+            }
+            for await (const [key, cardFacts] of facts) {
+                const shard = FactStore.shardOf(key);
+                buffers[shard] += FactStore.block(key, cardFacts);
+                if (buffers[shard].length >= FactStore.flushSize) {
+                    await handles[shard].write(buffers[shard], null, 'utf-8');
+                    buffers[shard] = '';
+                }
+            }
+            await Promise.all(handles.map((handle, shard) => handle.write(buffers[shard], null, 'utf-8')));
+        } catch (error) {
+            await Promise.all(handles.map(handle => handle.close()));
+            await Promise.all(files.map(file => rm(`${file}.tmp`, { force: true })));
+            throw error;
+        }
+        await Promise.all(handles.map(handle => handle.close()));
+        await Promise.all(files.map(file => rename(`${file}.tmp`, file)));
+    }
+
+    /**
+     * Adds or replaces facts of cards. Other cards keep their facts.
+     * @param {Map<string, string>} facts facts of each card.
+     */
+    public async update(facts: Map<string, string>) {
+        await mkdir(this.folder, { recursive: true });
+        const existing = new Set(await readdir(this.folder));
+        const shards = FactStore.byShard(facts);
+        await Promise.all(Array.from({ length: FactStore.shardCount }, async (_, shard) => {
+            const cards = shards.get(shard);
+            if (!cards && existing.has(FactStore.shardFile(shard))) {
+                return;
+            }
+            const blocks = await this.readShard(shard);
+            for (const [key, value] of cards ?? []) {
+                blocks.set(key, value);
+            }
+            await this.writeShard(shard, blocks);
+        }));
+    }
+}
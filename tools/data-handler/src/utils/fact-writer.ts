@@ -0,0 +1,70 @@
+/**
+ * Writes card metadata as logic program facts. Values are written according to the data type
+ * of their field: integers as clingo integers, booleans as constants 'true' and 'false', lists as
+ * one fact per element, and everything else as escaped strings. Missing values (null or undefined),
+ * also as list elements, are written as the string "null", so that modules can match unset fields;
+ * an empty list does not get a fact.
+ */
+export class FactWriter {
+
+    // Clingo integers are 32-bit; larger numbers are written as strings.
+    private static maxInteger: number = 2 ** 31 - 1;
+    private static minInteger: number = -(2 ** 31);
+
+    // Returns true, if value can be written as a clingo integer.
+    private static isInteger(value: number): boolean {
+        return Number.isInteger(value) && value >= FactWriter.minInteger && value <= FactWriter.maxInteger;
+    }
+
+    // Returns a single value as a term.
+    private static term(value: unknown, dataType?: string): string {
+        if (value === null || value === undefined) {
+            return '"null"';
+        }
+        if (typeof value === 'boolean' || (dataType === 'boolean' && (value === 'true' || value === 'false'))) {
+            return String(value);
+        }
+        if (dataType === 'integer' || dataType === 'number' || typeof value === 'number') {
+            const number = typeof value === 'string' && value.trim() !== '' ? Number(value) : value;
+            if (typeof number === 'number' && FactWriter.isInteger(number)) {
+                return String(number);
+            }
+        }
+        return FactWriter.string(String(value));
+    }
+
+    /**
+     * Returns facts of a metadata field.
+     * @param {string} cardKey card key
+     * @param {string} field field name
+     * @param {unknown} value field value
+     * @param {string} dataType data type of the field; if not known, type of the value is used.
+     * @returns facts; one for each element of a list, none for an empty list.
+     */
+    public static fieldFacts(cardKey: string, field: string, value: unknown, dataType?: string): string[] {
+        const values = Array.isArray(value) ? value : [value];
+        const elementType = Array.isArray(value) ? undefined : dataType;
+        return values.map(element => `field(${cardKey}, ${FactWriter.string(field)}, ${FactWriter.term(element, elementType)}).`);
+    }
+
+    /**
+     * Returns label facts of a card.
+     * @param {string} cardKey card key
+     * @param {unknown[]} labels labels of the card
+     * @returns one fact for each label.
+     */
+    public static labelFacts(cardKey: string, labels: unknown[]): string[] {
+        return labels
+            .filter(label => label !== null && label !== undefined)
+            .map(label => `label(${cardKey}, ${FactWriter.string(String(label))}).`);
+    }
+
+    /**
+     * Returns text as a logic program string.
+     * @param {string} text text
+     * @returns quoted string, where backslashes, quotes and line breaks are escaped.
+     */
+    public static string(text: string): string {
+        return `"${text.replace(/\\/g, '\\\\').replace(/"/g, '\\"').replace(/\r?\n/g, '\\n')}"`;
+    }
+}
@@ -3,6 +3,8 @@ import { existsSync, lstatSync, readdirSync } from 'node:fs';
 import { join } from 'node:path';
 import { homedir } from 'node:os';
 
+import { IOScheduler } from './io-scheduler.js';
+
 /**
  * Copies directory content (subdirectories and files) to destination.
  * Note that it won't create 'source', but copies all that is inside of 'source'.
@@ -10,22 +12,20 @@ import { homedir } from 'node:os';
  * @param destination path where to copy to
  */
 export async function copyDir(source: string, destination: string) {
-    const entries = await readdir(source, { withFileTypes: true });
-    for (const entry of entries) {
+    const scheduler = IOScheduler.getInstance();
+    const entries = await scheduler.schedule(() => readdir(source, { withFileTypes: true }));
+    if (!pathExists(destination)) {
+        await scheduler.schedule(() => mkdir(destination, { recursive: true }));
+    }
+    await Promise.all(entries.map(async entry => {
         const sourcePath = join(source, entry.name);
         const destinationPath = join(destination, entry.name);
         if (entry.isDirectory()) {
-            if (!pathExists(destinationPath)) {
-                await mkdir(destinationPath, { recursive: true });
-            }
             await copyDir(sourcePath, destinationPath);
         } else {
-            if (!pathExists(destination)) {
-                await mkdir(destination, { recursive: true });
-            }
-            await copyFile(sourcePath, destinationPath);
+            await scheduler.schedule(() => copyFile(sourcePath, destinationPath));
         }
-    }
+    }));
 }
 
 /**
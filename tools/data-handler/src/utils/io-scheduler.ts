@@ -0,0 +1,134 @@
+/**
+ * Priority of a scheduled file system operation.
+ * Interactive operations (e.g. reading one card for the app) are started before background
+ * operations (e.g. scanning the whole card tree).
+ */
+export type ioPriority = 'interactive' | 'background';
+
+// Counters of scheduled operations.
+export interface ioSchedulerStatistics {
+    concurrency: number
+    inFlight: number
+    queued: number
+    queuedInteractive: number
+    queuedBackground: number
+    completed: number
+    failed: number
+}
+
+/**
+ * Limits the number of concurrent file system operations. All card tree walkers share the
+ * same instance, so that wide card trees do not exhaust file handles or the libuv threadpool.
+ * Only leaf operations (single readdir, readFile, copyFile etc.) should be scheduled; an operation
+ * that waits for other scheduled operations could block the scheduler.
+ */
+export class IOScheduler {
+
+    private static instance: IOScheduler;
+
+    private completed: number = 0;
+    private failed: number = 0;
+    private inFlight: number = 0;
+    private queues: Record<ioPriority, (() => void)[]> = { interactive: [], background: [] };
+    private windowSize: number;
+
+    static defaultConcurrency = 64;
+
+    constructor(concurrency: number = IOScheduler.defaultConcurrency) {
+        this.windowSize = IOScheduler.validConcurrency(concurrency);
+    }
+
+    // Frees a place in the window for the next operation.
+    private operationFinished() {
+        this.inFlight--;
+        this.startQueued();
+    }
+
+    // Starts queued operations while there is room in the window.
+    private startQueued() {
+        while (this.inFlight < this.windowSize) {
+            const start = this.queues.interactive.shift() || this.queues.background.shift();
+            if (!start) {
+                return;
+            }
+            this.inFlight++;
+            start();
+        }
+    }
+
+    // Checks that concurrency is a positive integer.
+    private static validConcurrency(concurrency: number): number {
+        if (!Number.isInteger(concurrency) || concurrency < 1) {
+            throw new Error(`Invalid I/O concurrency '${concurrency}'; must be a positive integer`);
+        }
+        return concurrency;
+    }
+
+    /**
+     * Getter. Returns the maximum number of concurrent operations.
+     */
+    public get concurrency(): number {
+        return this.windowSize;
+    }
+
+    /**
+     * Returns shared scheduler instance.
+     * @returns shared scheduler.
+     */
+    public static getInstance(): IOScheduler {
+        if (!IOScheduler.instance) {
+            IOScheduler.instance = new IOScheduler();
+        }
+        return IOScheduler.instance;
+    }
+
+    /**
+     * Schedules an operation. Operation is started when there is room in the concurrency window.
+     * @param {() => Promise<T>} operation file system operation to run.
+     * @param {ioPriority} priority operation priority; by default 'background'.
+     * @returns result of the operation.
+     */
+    public schedule<T>(operation: () => Promise<T>, priority: ioPriority = 'background'): Promise<T> {
+        return new Promise<T>((resolve, reject) => {
+            this.queues[priority].push(() => {
+                Promise.resolve()
+                    .then(operation)
+                    .then(result => {
+                        this.completed++;
+                        this.operationFinished();
+                        resolve(result);
+                    }, error => {
+                        this.failed++;
+                        this.operationFinished();
+                        reject(error);
+                    });
+            });
+            this.startQueued();
+        });
+    }
+
+    /**
+     * Changes the maximum number of concurrent operations.
+     * @param {number} concurrency maximum number of concurrent operations.
+     */
+    public setConcurrency(concurrency: number) {
+        this.windowSize = IOScheduler.validConcurrency(concurrency);
+        this.startQueued();
+    }
+
+    /**
+     * Returns counters of queued, in-flight and finished operations.
+     * @returns scheduler statistics.
+     */
+    public statistics(): ioSchedulerStatistics {
+        return {
+            concurrency: this.windowSize,
+            inFlight: this.inFlight,
+            queued: this.queues.interactive.length + this.queues.background.length,
+            queuedInteractive: this.queues.interactive.length,
+            queuedBackground: this.queues.background.length,
+            completed: this.completed,
+            failed: this.failed,
+        };
+    }
+}
@@ -233,9 +233,8 @@ export class Validate {
 
                 // Finally, validate that each card is correct
                 const project = new Project(projectPath);
-                const cards = await project.cards();
                 const errorMsg: string[] = [];
-                for (const card of cards) {
+                for await (const card of project.iterateCards({ metadata: true })) {
                     if (card.metadata) {
                         // validate card's workflow
                         const validWorkflow = await this.validateWorkflowState(project, card);
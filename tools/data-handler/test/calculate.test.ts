@@ -0,0 +1,295 @@
+// testing
+import { expect } from 'chai';
+import { after, before, beforeEach, describe, it } from 'mocha';
+
+// node
+import { chmodSync, mkdirSync, readdirSync, readFileSync, rmSync, writeFileSync } from 'node:fs';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+// ismo
+import { Calculate, calculationProfile } from '../src/calculate.js';
+import { CalculationCache } from '../src/utils/calculation-cache.js';
+import { calculationJob, CalculationQueue } from '../src/utils/calculation-queue.js';
+import { ClingoEngine } from '../src/utils/clingo-engine.js';
+import { Cmd, Commands } from '../src/command-handler.js';
+import { copyDir } from '../src/utils/file-utils.js';
+import { Project } from '../src/containers/project.js';
+import { Remove } from '../src/remove.js';
+import { Validate } from '../src/validate.js';
+
+// Create test artifacts in a temp directory.
+const baseDir = dirname(fileURLToPath(import.meta.url));
+const testDir = join(baseDir, 'tmp-calculate-tests');
+const callsFolder = join(testDir, 'calls');
+
+// Fake clingo (CommonJS script) without worker support. Calculates one field for each card that
+// the query selects; if the query does not select cards, for all cards that the tests use.
+// Value of the field is the number of the solve, so that tests can tell recalculated results from cached ones.
+// Each solve claims its number by creating a file in 'callsFolder'.
+// Grounding writes a single fact. With statistics, the number of rules is the number of loaded files.
+// If FAKE_CLINGO_QUERY_FILE is set, the query is written to that file.
+function fakeClingo(name: string): string {
+    const file = join(testDir, name);
+    writeFileSync(file, `#!/usr/bin/env node
+const worker = process.argv.some(arg => arg.endsWith('${ClingoEngine.workerFileName}'));
+if (worker) {
+    process.exit(65);
+}
+if (process.argv.includes('--text')) {
+    console.log('grounded.');
+    process.exit(0);
+}
+let input = '';
+process.stdin.on('data', data => input += data);
+process.stdin.on('end', () => {
+    if (process.env.FAKE_CLINGO_QUERY_FILE) {
+        require('node:fs').writeFileSync(process.env.FAKE_CLINGO_QUERY_FILE, input);
+    }
+    if (process.argv.includes('--stats')) {
+        const files = process.argv.filter(arg => arg.endsWith('.lp'));
+        console.log('SATISFIABLE\\n\\nTime         : 0.250s (Solving: 0.05s 1st Model: 0.00s Unsat: 0.00s)');
+        console.log('Rules        : ' + files.length + '\\n  Choice     : 0\\nAtoms        : 7');
+        process.exit(30);
+    }
+    let call = 1;
+    for (;;) {
+        try {
+            require('node:fs').writeFileSync(require('node:path').join(${JSON.stringify(callsFolder)}, String(call)), '', { flag: 'wx' });
+            break;
+        } catch {
+            call++;
+        }
+    }
+    const selected = input.match(/Cardkey = \\(([^)]*)\\)/);
+    const keys = selected ? selected[1].split(';') : ['decision_5', 'decision_6', 'decision_7'];
+    for (const key of keys) {
+        const value = call;
+        console.log('field(' + key + ',"calculated",' + value + ') fieldtype(' + key + ',"calculated",integer)');
+    }
+    console.log('SATISFIABLE');
+});
+`);
+    chmodSync(file, 0o755);
+    return file;
+}
+
+// Returns the number of solves that the fake clingo has run.
+function solveCount(): number {
+    return readdirSync(callsFolder).length;
+}
+
+// Adds a top level card to the project, and calculates its facts.
+async function addCard(projectPath: string, cardKey: string) {
+    const project = new Project(projectPath);
+    const newCard = join(project.cardrootFolder, cardKey);
+    mkdirSync(newCard);
+    writeFileSync(join(newCard, Project.cardMetadataFile), JSON.stringify({ cardtype: 'simplepage-cardtype', summary: 'Other', workflowState: 'Created' }));
+    await new Calculate().handleNewCards([(await project.findSpecificCard(cardKey))!]);
+    await CalculationQueue.getInstance(projectPath).idle();
+}
+
+describe('calculate', () => {
+    const binaryName = ClingoEngine.binaryName;
+    let decisionRecordsPath: string;
+    let projectCount = 0;
+
+    before(() => {
+        mkdirSync(callsFolder, { recursive: true });
+        ClingoEngine.binaryName = fakeClingo('clingo-batch.cjs');
+    });
+
+    // Each test has its own copy of the project, and so its own calculation queue and cache.
+    beforeEach(async () => {
+        decisionRecordsPath = join(testDir, `decision-records-${++projectCount}`);
+        await copyDir('test/test-data/valid/decision-records', decisionRecordsPath);
+        await new Calculate().generate(decisionRecordsPath);
+    });
+
+    after(() => {
+        ClingoEngine.binaryName = binaryName;
+        rmSync(testDir, { recursive: true, force: true });
+    });
+
+    it('runBatch() calculates listed cards with one solve', async () => {
+        const results = await new Calculate().runBatch(decisionRecordsPath, ['decision_5', 'decision_6', 'decision_5']);
+        expect(Object.keys(results).sort()).to.deep.equal(['decision_5', 'decision_6']);
+        expect(results['decision_6'][0].field).to.equal('calculated');
+        expect(results['decision_6'][0].value).to.equal(solveCount());
+        expect(results['decision_5'][0].value).to.equal(solveCount());
+    });
+    it('runBatch() calculates a subtree', async () => {
+        const results = await new Calculate().runBatch(decisionRecordsPath, { subtree: 'decision_6' });
+        expect(Object.keys(results)).to.deep.equal(['decision_6']);
+    });
+    it('runBatch() calculates all cards', async () => {
+        const queryFile = join(testDir, 'query.lp');
+        process.env.FAKE_CLINGO_QUERY_FILE = queryFile;
+        try {
+            const results = await new Calculate().runBatch(decisionRecordsPath, 'all');
+            expect(Object.keys(results).sort()).to.deep.equal(['decision_5', 'decision_6']);
+        } finally {
+            delete process.env.FAKE_CLINGO_QUERY_FILE;
+        }
+        // All cards are calculated without listing them in the query.
+        expect(readFileSync(queryFile, { encoding: 'utf-8' })).to.not.include('Cardkey = (');
+    });
+    it('try to runBatch() with unknown card', async () => {
+        try {
+            await new Calculate().runBatch(decisionRecordsPath, ['decision_5', 'decision_999']);
+            expect(false).to.equal(true);
+        } catch (error) {
+            expect((error as Error).message).to.equal(`Card 'decision_999' not found`);
+        }
+    });
+    it('calc run --all', async () => {
+        const commandHandler = new Commands();
+        const result = await commandHandler.command(Cmd.calc, ['run'], { projectPath: decisionRecordsPath, all: true });
+        expect(result.statusCode).to.equal(200);
+        expect(Object.keys(result.payload as object).sort()).to.deep.equal(['decision_5', 'decision_6']);
+
+        const invalid = await commandHandler.command(Cmd.calc, ['run', 'decision_5'], { projectPath: decisionRecordsPath, all: true });
+        expect(invalid.statusCode).to.equal(400);
+    });
+    it('run() with cone caching uses cached results until dependency cone changes', async () => {
+        Calculate.coneCaching = true;
+        try {
+            const calculate = new Calculate();
+            const project = new Project(decisionRecordsPath);
+            await addCard(decisionRecordsPath, 'decision_7');
+
+            const first = await calculate.runBatch(decisionRecordsPath, 'all');
+            expect(Object.keys(first).sort()).to.deep.equal(['decision_5', 'decision_6', 'decision_7']);
+            const firstSolve = solveCount();
+            expect(readdirSync(join(project.calculationFolder, CalculationCache.folderName)).length).to.equal(3);
+            expect(await Validate.getInstance().validate(decisionRecordsPath)).to.equal('');
+            expect(await calculate.run(decisionRecordsPath, 'decision_5')).to.deep.equal(first['decision_5']);
+
+            // Changing a child changes results of the child and its parent; other cards keep their results.
+            const card = await project.findSpecificCard('decision_6', { metadata: true });
+            writeFileSync(join(card!.path, Project.cardMetadataFile), JSON.stringify({ ...card!.metadata, summary: 'Changed' }));
+            await calculate.handleCardChanged(card!);
+            await CalculationQueue.getInstance(decisionRecordsPath).idle();
+
+            const second = await calculate.runBatch(decisionRecordsPath, 'all');
+            expect(solveCount()).to.equal(firstSolve + 1);
+            expect(second['decision_5'][0].value).to.equal(firstSolve + 1);
+            expect(second['decision_6'][0].value).to.equal(firstSolve + 1);
+            expect(second['decision_7']).to.deep.equal(first['decision_7']);
+        } finally {
+            Calculate.coneCaching = false;
+        }
+    });
+    it('run() uses cached results until facts of any card change', async () => {
+        const calculate = new Calculate();
+        const project = new Project(decisionRecordsPath);
+        await addCard(decisionRecordsPath, 'decision_7');
+        const first = await calculate.runBatch(decisionRecordsPath, 'all');
+        const firstSolve = solveCount();
+        expect(first['decision_7'][0].value).to.equal(firstSolve);
+        expect(await calculate.runBatch(decisionRecordsPath, 'all')).to.deep.equal(first);
+        expect(solveCount()).to.equal(firstSolve);
+
+        const card = await project.findSpecificCard('decision_6', { metadata: true });
+        writeFileSync(join(card!.path, Project.cardMetadataFile), JSON.stringify({ ...card!.metadata, summary: 'Changed' }));
+        await calculate.handleCardChanged(card!);
+        await CalculationQueue.getInstance(decisionRecordsPath).idle();
+
+        // Card outside of the changed card's dependency cone is calculated again, too.
+        const second = await calculate.runBatch(decisionRecordsPath, 'all');
+        expect(second['decision_7'][0].value).to.equal(solveCount());
+        expect(second['decision_7'][0].value).to.not.equal(firstSolve);
+    });
+    it('card details include calculated fields', async () => {
+        const calculate = new Calculate();
+        const project = new Project(decisionRecordsPath);
+        const expected = await calculate.run(decisionRecordsPath, 'decision_6');
+
+        const card = await project.findSpecificCard('decision_6', { calculations: true });
+        expect(card?.calculations).to.deep.equal(expected);
+        const tree = await project.cardTree({ calculations: true }, 'decision_5');
+        expect(tree[0].children?.[0].calculations).to.deep.equal(expected);
+        const templateCard = await project.findSpecificCard('decision_1', { calculations: true });
+        expect(templateCard?.calculations).to.deep.equal([]);
+    });
+    it('cached card calculations do not wait for the solver', async () => {
+        const calculate = new Calculate();
+        const project = new Project(decisionRecordsPath);
+
+        const missing = await calculate.cachedCardCalculations(project, ['decision_6', 'decision_1']);
+        expect(missing.calculations).to.deep.equal({});
+        expect(missing.job?.name).to.equal('run');
+        const again = await calculate.cachedCardCalculations(project, ['decision_6']);
+        expect(again.job?.id).to.equal(missing.job?.id);
+        await CalculationQueue.getInstance(decisionRecordsPath).idle();
+
+        const solves = solveCount();
+        const cached = await calculate.cachedCardCalculations(project, ['decision_6', 'decision_1']);
+        expect(cached.job).to.equal(undefined);
+        expect(cached.calculations).to.deep.equal({ decision_6: await calculate.run(decisionRecordsPath, 'decision_6') });
+        expect(solveCount()).to.equal(solves);
+    });
+    it('changes made in quick succession are recalculated together', async () => {
+        const calculate = new Calculate();
+        const project = new Project(decisionRecordsPath);
+        const queue = CalculationQueue.getInstance(decisionRecordsPath);
+        await addCard(decisionRecordsPath, 'decision_7');
+        const cards = await Promise.all(['decision_5', 'decision_6', 'decision_7'].map(key => project.findSpecificCard(key)));
+        const jobCount = calculate.jobs(decisionRecordsPath).length;
+
+        const first = await calculate.handleCardChanged(cards[0]!);
+        const second = await calculate.handleCardChanged(cards[1]!);
+        await new Remove(calculate).remove(decisionRecordsPath, 'card', cards[2]!.key);
+        expect((second.payload as calculationJob).id).to.equal((first.payload as calculationJob).id);
+        await queue.idle();
+
+        const updates = calculate.jobs(decisionRecordsPath).slice(jobCount).filter(job => job.name === 'update');
+        expect(updates.length).to.equal(1);
+        expect(updates[0].state).to.equal('done');
+        expect(Object.keys(await calculate.runBatch(decisionRecordsPath, 'all')).sort()).to.deep.equal(['decision_5', 'decision_6']);
+    });
+    it('calc run --ground-only and --solve-only', async () => {
+        const commandHandler = new Commands();
+        const project = new Project(decisionRecordsPath);
+        const options = { projectPath: decisionRecordsPath };
+
+        const notGrounded = await commandHandler.command(Cmd.calc, ['run', 'decision_5'], { ...options, solveOnly: true });
+        expect(notGrounded.statusCode).to.equal(400);
+        expect(notGrounded.message).to.include('--ground-only');
+
+        const grounded = await commandHandler.command(Cmd.calc, ['run'], { ...options, groundOnly: true });
+        expect(grounded.statusCode).to.equal(200);
+        expect(readFileSync(join(project.calculationFolder, ClingoEngine.groundFileName), 'utf-8')).to.include('grounded.');
+        expect(await Validate.getInstance().validate(decisionRecordsPath)).to.equal('');
+
+        const solved = await commandHandler.command(Cmd.calc, ['run', 'decision_5'], { ...options, solveOnly: true });
+        expect(solved.statusCode).to.equal(200);
+        const all = await commandHandler.command(Cmd.calc, ['run'], { ...options, all: true, solveOnly: true });
+        expect(Object.keys(all.payload as object).sort()).to.deep.equal(['decision_5', 'decision_6']);
+
+        const invalid = await commandHandler.command(Cmd.calc, ['run', 'decision_5'], { ...options, groundOnly: true });
+        expect(invalid.statusCode).to.equal(400);
+    });
+    it('calc run --profile', async () => {
+        const commandHandler = new Commands();
+        const options = { projectPath: decisionRecordsPath, profile: true };
+        const result = await commandHandler.command(Cmd.calc, ['run', 'decision_5'], options);
+        expect(result.statusCode).to.equal(200);
+        const profile = result.payload as calculationProfile;
+        expect(profile.cardKey).to.equal('decision_5');
+        expect(profile.program.totalTime).to.equal(0.25);
+        expect(profile.program.solvingTime).to.equal(0.05);
+        expect(profile.program.groundingTime).to.be.closeTo(0.2, 1e-9);
+        expect(profile.program.rules).to.equal(1);
+        expect(profile.base.rules).to.equal(2);
+        expect(profile.modules.length).to.equal(1);
+        expect(profile.modules[0].file).to.match(/test\.lp$/);
+        expect(profile.modules[0].statistics?.rules).to.equal(3);
+        expect(profile.modules[0].statistics?.atoms).to.equal(7);
+
+        const invalid = await commandHandler.command(Cmd.calc, ['run'], { ...options, all: true });
+        expect(invalid.statusCode).to.equal(400);
+        const unknown = await commandHandler.command(Cmd.calc, ['run', 'decision_999'], options);
+        expect(unknown.statusCode).to.equal(400);
+    });
+});
@@ -0,0 +1,115 @@
+// testing
+import { expect } from 'chai';
+import { after, before, describe, it } from 'mocha';
+
+// node
+import { mkdirSync, rmSync } from 'node:fs';
+import { mkdir, rename, rm, writeFile } from 'node:fs/promises';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+// ismo
+import { CardIndex } from '../src/containers/card-index.js';
+import { copyDir } from '../src/utils/file-utils.js';
+import { Project } from '../src/containers/project.js';
+
+// Create test artifacts in a temp directory.
+const baseDir = dirname(fileURLToPath(import.meta.url));
+const testDir = join(baseDir, 'tmp-card-index-tests');
+
+before(async () => {
+    mkdirSync(testDir);
+    await copyDir('test/test-data/', testDir);
+});
+
+after(() => {
+    rmSync(testDir, { recursive: true, force: true });
+});
+
+describe('card index', () => {
+    const decisionRecordsPath = join(testDir, 'valid/decision-records');
+    const cardroot = join(decisionRecordsPath, 'cardroot');
+
+    it('finds cards and their relations', async () => {
+        const index = CardIndex.getInstance(cardroot);
+        const card = await index.find('decision_6');
+        expect(card?.path).to.equal(join(cardroot, 'decision_5', 'c', 'decision_6'));
+        expect(card?.parent).to.equal('decision_5');
+        expect(await index.children('decision_5')).to.include('decision_6');
+        expect(await index.children(CardIndex.rootKey)).to.include('decision_5');
+        expect(await index.find('decision_999')).to.equal(undefined);
+    });
+    it('lists keys of a card and its descendants', async () => {
+        const index = CardIndex.getInstance(cardroot);
+        expect(await index.keys('decision_5')).to.deep.equal(['decision_5', 'decision_6']);
+        expect(await index.keys('decision_6')).to.deep.equal(['decision_6']);
+        expect(await index.keys('decision_999')).to.deep.equal([]);
+        expect(await index.keys()).to.include('decision_6');
+    });
+    it('shares index between project objects', async () => {
+        const project = new Project(decisionRecordsPath);
+        const anotherProject = new Project(decisionRecordsPath);
+        expect(project.cardIndex).to.equal(anotherProject.cardIndex);
+        expect(project.cardIndex).to.equal(CardIndex.getInstance(cardroot));
+        expect(CardIndex.owning(join(cardroot, 'decision_5'))).to.equal(project.cardIndex);
+    });
+    it('notices cards that are added, moved and removed outside of commands', async () => {
+        const index = CardIndex.getInstance(cardroot);
+        await index.update();
+
+        const newCard = join(cardroot, 'decision_5', 'c', 'decision_100');
+        await mkdir(newCard, { recursive: true });
+        await writeFile(join(newCard, Project.cardMetadataFile), '{}');
+        expect((await index.find('decision_100'))?.parent).to.equal('decision_5');
+
+        const movedCard = join(cardroot, 'decision_100');
+        await rename(newCard, movedCard);
+        const moved = await index.find('decision_100');
+        expect(moved?.path).to.equal(movedCard);
+        expect(moved?.parent).to.equal(CardIndex.rootKey);
+        expect(await index.children('decision_5')).to.not.include('decision_100');
+
+        await rm(movedCard, { recursive: true, force: true });
+        expect(await index.find('decision_100')).to.equal(undefined);
+    });
+    it('re-checks the tree for a missing card at most once in a while', async () => {
+        const index = CardIndex.getInstance(cardroot);
+        await index.update();
+        expect(await index.find('decision_102')).to.equal(undefined);
+
+        // Card that was just looked for is not looked for again right away.
+        const newCard = join(cardroot, 'decision_102');
+        await mkdir(newCard, { recursive: true });
+        expect(await index.find('decision_102')).to.equal(undefined);
+
+        const interval = CardIndex.missIntervalMs;
+        CardIndex.missIntervalMs = 0;
+        try {
+            expect((await index.find('decision_102'))?.path).to.equal(newCard);
+        } finally {
+            CardIndex.missIntervalMs = interval;
+            await rm(newCard, { recursive: true, force: true });
+        }
+    });
+    it('updates index when cards are created and removed', async () => {
+        const index = CardIndex.getInstance(cardroot);
+        await index.update();
+
+        const newCard = join(cardroot, 'decision_101');
+        await mkdir(newCard, { recursive: true });
+        await index.add('decision_101', newCard);
+        expect((await index.find('decision_101'))?.path).to.equal(newCard);
+
+        await rm(newCard, { recursive: true, force: true });
+        await index.remove('decision_101');
+        expect(await index.children(CardIndex.rootKey)).to.not.include('decision_101');
+    });
+    it('re-builds index after invalidation', async () => {
+        const index = CardIndex.getInstance(cardroot);
+        await index.update();
+        CardIndex.invalidateFolder(decisionRecordsPath);
+        const newIndex = CardIndex.getInstance(cardroot);
+        expect(newIndex).to.not.equal(index);
+        expect((await newIndex.find('decision_5'))?.path).to.equal(join(cardroot, 'decision_5'));
+    });
+});
@@ -0,0 +1,61 @@
+// testing
+import { expect } from 'chai';
+import { after, before, describe, it } from 'mocha';
+
+// node
+import { mkdirSync, rmSync } from 'node:fs';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+// ismo
+import { copyDir } from '../src/utils/file-utils.js';
+import { Import } from '../src/import.js';
+import { ModuleRegistry } from '../src/containers/module-registry.js';
+import { Project } from '../src/containers/project.js';
+
+// Create test artifacts in a temp directory.
+const baseDir = dirname(fileURLToPath(import.meta.url));
+const testDir = join(baseDir, 'tmp-module-registry-tests');
+
+describe('module registry', () => {
+    const decisionRecordsPath = join(testDir, 'valid/decision-records');
+    const minimalPath = join(testDir, 'valid/minimal');
+    const modulesFolder = join(decisionRecordsPath, '.cards', 'modules');
+
+    before(async () => {
+        mkdirSync(testDir);
+        await copyDir('test/test-data/', testDir);
+    });
+
+    after(() => {
+        rmSync(testDir, { recursive: true, force: true });
+    });
+
+    it('project without modules', async () => {
+        const registry = ModuleRegistry.getInstance(modulesFolder);
+        expect(await registry.modules()).to.deep.equal([]);
+        expect(await registry.resources('cardtypes')).to.deep.equal([]);
+        expect(await registry.find('cardtypes', 'mini/myCardtype.json')).to.equal(undefined);
+    });
+    it('imported module is added to the registry', async () => {
+        const registry = ModuleRegistry.getInstance(modulesFolder);
+        await new Import().importProject(minimalPath, decisionRecordsPath, 'mini');
+
+        expect((await registry.modules()).map(item => item.name)).to.deep.equal(['mini']);
+        const cardtype = await registry.find('cardtypes', 'mini/myCardtype.json');
+        expect(cardtype?.path).to.equal(join(modulesFolder, 'mini', 'cardtypes'));
+        expect(await registry.moduleResourceNames('mini', 'templates')).to.deep.equal(['mini/test-template']);
+        expect(await registry.moduleResourceNames('mini', 'calculations')).to.deep.equal(['mini/test.lp']);
+
+        const project = new Project(decisionRecordsPath);
+        expect(await project.moduleNames()).to.deep.equal(['mini']);
+        expect(await project.modulePath('mini')).to.equal(join(modulesFolder, 'mini'));
+        expect((await project.cardType('mini/myCardtype'))?.name).to.equal('mini/myCardtype');
+    });
+    it('notices modules removed outside of commands', async () => {
+        const registry = ModuleRegistry.getInstance(modulesFolder);
+        rmSync(join(modulesFolder, 'mini'), { recursive: true, force: true });
+        expect(await registry.modules()).to.deep.equal([]);
+        expect(await new Project(decisionRecordsPath).cardType('mini/myCardtype')).to.equal(undefined);
+    });
+});
@@ -0,0 +1,100 @@
+// testing
+import { expect } from 'chai';
+import { after, before, describe, it } from 'mocha';
+
+// node
+import { mkdirSync, rmSync } from 'node:fs';
+import { writeFile } from 'node:fs/promises';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+// ismo
+import { ClingoEngine } from '../src/utils/clingo-engine.js';
+import { copyDir } from '../src/utils/file-utils.js';
+import { Project } from '../src/containers/project.js';
+import { ProjectSession } from '../src/containers/project-session.js';
+
+// Create test artifacts in a temp directory.
+const baseDir = dirname(fileURLToPath(import.meta.url));
+const testDir = join(baseDir, 'tmp-project-session-tests');
+
+// Waits until 'condition' is true, or timeout expires.
+async function waitFor(condition: () => Promise<boolean>, timeout: number = 2000) {
+    const end = Date.now() + timeout;
+    while (!await condition() && Date.now() < end) {
+        await new Promise(resolve => setTimeout(resolve, 20));
+    }
+}
+
+describe('project session', () => {
+    const decisionRecordsPath = join(testDir, 'valid/decision-records');
+    const persistent = ClingoEngine.persistent;
+    let session: ProjectSession;
+
+    before(async () => {
+        mkdirSync(testDir);
+        await copyDir('test/test-data/', testDir);
+        session = ProjectSession.getInstance(decisionRecordsPath);
+    });
+
+    after(() => {
+        session.close();
+        ClingoEngine.persistent = persistent;
+        rmSync(testDir, { recursive: true, force: true });
+    });
+
+    it('shares session and caches results', async () => {
+        expect(ProjectSession.getInstance(decisionRecordsPath)).to.equal(session);
+        // Long-lived session keeps the logic program loaded in solver workers.
+        expect(ClingoEngine.persistent).to.equal(true);
+        expect(session.project).to.equal(session.project);
+        const cards = await session.cards();
+        expect(cards.length).to.be.greaterThan(0);
+        expect(await session.cards()).to.equal(cards);
+        expect((await session.cardTypes()).length).to.be.greaterThan(0);
+        expect((await session.workflows()).length).to.be.greaterThan(0);
+        expect(await session.templates()).to.equal(await session.templates());
+    });
+    it('notices changed card content', async () => {
+        const details = { content: true, metadata: true };
+        const card = await session.cardDetails('decision_5', details);
+        expect(await session.cardDetails('decision_5', details)).to.equal(card);
+        const cards = await session.cards();
+
+        await writeFile(join(card.path, Project.cardContentFile), 'Changed content');
+        await waitFor(async () => (await session.cardDetails('decision_5', details)).content === 'Changed content');
+        expect((await session.cardDetails('decision_5', details)).content).to.equal('Changed content');
+        // Content is not part of the card tree.
+        expect(await session.cards()).to.equal(cards);
+    });
+    it('notices changed card metadata', async () => {
+        const cards = await session.cards();
+        const card = await session.cardDetails('decision_5', { metadata: true });
+        await writeFile(join(card.path, Project.cardMetadataFile), JSON.stringify({ ...card.metadata, summary: 'Changed' }));
+        await waitFor(async () => (await session.cards()) !== cards);
+        expect(await session.cards()).to.not.equal(cards);
+        expect((await session.cardDetails('decision_5', { metadata: true })).metadata?.summary).to.equal('Changed');
+    });
+    it('forgets changed card when told so', async () => {
+        const details = { content: true };
+        const card = await session.cardDetails('decision_6', details);
+        session.cardChanged('decision_6');
+        expect(await session.cardDetails('decision_6', details)).to.not.equal(card);
+    });
+    it('card details have calculated fields; without generated calculations there are none', async () => {
+        const details = { content: true, calculations: true as const };
+        const card = await session.cardDetails('decision_5', details);
+        expect(card.calculations).to.deep.equal([]);
+        expect(card.content).to.equal((await session.cardDetails('decision_5', { content: true })).content);
+    });
+    it('try to get card that does not exist', async () => {
+        try {
+            await session.cardDetails('decision_999', {});
+            expect(false).to.equal(true);
+        } catch (error) {
+            if (error instanceof Error) {
+                expect(error.message).to.equal(`Card 'decision_999' does not exist in the project`);
+            }
+        }
+    });
+});
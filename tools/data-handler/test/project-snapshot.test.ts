@@ -0,0 +1,115 @@
+// testing
+import { expect } from 'chai';
+import { after, before, describe, it } from 'mocha';
+
+// node
+import { mkdirSync, rmSync } from 'node:fs';
+import { mkdir, readFile, writeFile } from 'node:fs/promises';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+// ismo
+import { CardIndex } from '../src/containers/card-index.js';
+import { Cmd, Commands } from '../src/command-handler.js';
+import { copyDir, pathExists } from '../src/utils/file-utils.js';
+import { Project } from '../src/containers/project.js';
+import { ProjectSnapshot } from '../src/containers/project-snapshot.js';
+import { Validate } from '../src/validate.js';
+
+// Create test artifacts in a temp directory.
+const baseDir = dirname(fileURLToPath(import.meta.url));
+const testDir = join(baseDir, 'tmp-project-snapshot-tests');
+
+before(async () => {
+    mkdirSync(testDir);
+    await copyDir('test/test-data/', testDir);
+});
+
+after(() => {
+    rmSync(testDir, { recursive: true, force: true });
+});
+
+describe('project snapshot', () => {
+    const decisionRecordsPath = join(testDir, 'valid/decision-records');
+    const cardroot = join(decisionRecordsPath, 'cardroot');
+    const snapshotFolder = join(decisionRecordsPath, '.calc', ProjectSnapshot.folderName);
+
+    it('stores card index, metadata and resources', async () => {
+        const project = new Project(decisionRecordsPath);
+        const cards = await project.cardTree({ metadata: true });
+        expect(cards.length).to.be.greaterThan(0);
+        expect(pathExists(join(decisionRecordsPath, '.cards', 'snapshot.json'))).to.equal(false);
+        // Reading cards does not write the snapshot.
+        expect(pathExists(snapshotFolder)).to.equal(false);
+        await project.saveSnapshot();
+
+        const cardsContent = JSON.parse(await readFile(join(snapshotFolder, ProjectSnapshot.cardsFileName), { encoding: 'utf-8' }));
+        expect(cardsContent.version).to.equal(ProjectSnapshot.version);
+        const index = cardsContent.indexes['cardroot'];
+        expect(index.cards.map((item: { key: string }) => item.key)).to.include('decision_6');
+        expect(Object.keys(cardsContent.metadata)).to.include(join('cardroot', 'decision_5', Project.cardMetadataFile));
+
+        const resourcesContent = JSON.parse(await readFile(join(snapshotFolder, ProjectSnapshot.resourcesFileName), { encoding: 'utf-8' }));
+        expect(resourcesContent.version).to.equal(ProjectSnapshot.version);
+        expect(Object.keys(resourcesContent.resources).length).to.be.greaterThan(0);
+
+        // Snapshot is kept with the other cached files, and the project is still valid.
+        const valid = await Validate.getInstance().validate(decisionRecordsPath);
+        expect(valid.length).to.equal(0);
+    });
+    it('restores card index from stored state', async () => {
+        const snapshot = new ProjectSnapshot(decisionRecordsPath);
+        const state = await snapshot.cardIndexState(cardroot);
+        const decision6 = state?.cards.find(item => item.key === 'decision_6');
+        expect(decision6?.parent).to.equal('decision_5');
+        expect(decision6?.path).to.equal(join('decision_5', 'c', 'decision_6'));
+
+        // New index instance corresponds to a new process; it notices cards added after snapshot was stored.
+        const newCard = join(cardroot, 'decision_5', 'c', 'decision_200');
+        await mkdir(newCard, { recursive: true });
+        await writeFile(join(newCard, Project.cardMetadataFile), '{}');
+        const index = new CardIndex(cardroot);
+        expect((await index.find('decision_6'))?.parent).to.equal('decision_5');
+        expect((await index.find('decision_200'))?.parent).to.equal('decision_5');
+    });
+    it('re-reads changed metadata', async () => {
+        const snapshot = ProjectSnapshot.getInstance(decisionRecordsPath);
+        const metadataFile = join(cardroot, 'decision_5', Project.cardMetadataFile);
+        const metadata = await snapshot.cardMetadata(metadataFile);
+
+        metadata.summary = 'Changed summary';
+        await writeFile(metadataFile, JSON.stringify(metadata));
+        expect((await snapshot.cardMetadata(metadataFile)).summary).to.equal('Changed summary');
+
+        // Returned metadata is a copy; changing it does not change the snapshot.
+        const copy = await snapshot.cardMetadata(metadataFile);
+        copy.summary = 'Not stored';
+        expect((await snapshot.cardMetadata(metadataFile)).summary).to.equal('Changed summary');
+    });
+    it('keeps metadata of most recently read cards', async () => {
+        const maxCards = ProjectSnapshot.maxCards;
+        ProjectSnapshot.maxCards = 1;
+        try {
+            const snapshot = new ProjectSnapshot(decisionRecordsPath);
+            const first = join(cardroot, 'decision_5', Project.cardMetadataFile);
+            const second = join(cardroot, 'decision_5', 'c', 'decision_6', Project.cardMetadataFile);
+            await snapshot.cardMetadata(first);
+            await snapshot.cardMetadata(second);
+            await snapshot.save();
+            const cardsContent = JSON.parse(await readFile(join(snapshotFolder, ProjectSnapshot.cardsFileName), { encoding: 'utf-8' }));
+            expect(Object.keys(cardsContent.metadata)).to.deep.equal([join('cardroot', 'decision_5', 'c', 'decision_6', Project.cardMetadataFile)]);
+        } finally {
+            ProjectSnapshot.maxCards = maxCards;
+        }
+    });
+    it('reading commands do not write the snapshot; changing commands do', async () => {
+        const commands = new Commands();
+        const options = { projectPath: decisionRecordsPath };
+        rmSync(snapshotFolder, { recursive: true, force: true });
+        expect((await commands.command(Cmd.validate, [], options)).statusCode).to.equal(200);
+        expect((await commands.command(Cmd.show, ['cards'], options)).statusCode).to.equal(200);
+        expect(pathExists(snapshotFolder)).to.equal(false);
+        expect((await commands.command(Cmd.create, ['card', 'simplepage'], options)).statusCode).to.equal(200);
+        expect(pathExists(join(snapshotFolder, ProjectSnapshot.cardsFileName))).to.equal(true);
+    });
+});
@@ -4,6 +4,7 @@ import { after, before, describe, it } from 'mocha';
 
 // node
 import { mkdirSync, rmSync } from 'node:fs';
+import { readFile, writeFile } from 'node:fs/promises';
 import { basename, dirname, join, resolve, sep } from 'node:path';
 
 // ismo
@@ -254,14 +255,14 @@ describe('project', () => {
         const templateCard = 'decision_1';
         const template = 'decision';
 
-        const cardExists = project.hasCard(cardToOperateOn);
+        const cardExists = await project.hasCard(cardToOperateOn);
         expect(cardExists).to.equal(true);
         const templateObject = await project.createTemplateObjectByName(template);
         if (templateObject) {
-            const templateCardExists = templateObject.hasCard(templateCard);
+            const templateCardExists = await templateObject.hasCard(templateCard);
             expect(templateCardExists).to.equal(true);
         }
-        const pathToCard = project.pathToCard(cardToOperateOn);
+        const pathToCard = await project.pathToCard(cardToOperateOn);
         expect(pathToCard).to.include('decision_5');
     });
 
@@ -272,7 +273,7 @@ describe('project', () => {
         expect(project).to.not.equal(undefined);
 
         const cardToOperateOn = 'decision_5';
-        const cardExists = project.hasCard(cardToOperateOn);
+        const cardExists = await project.hasCard(cardToOperateOn);
         expect(cardExists).to.equal(true);
 
         const card = await project.cardDetailsById(cardToOperateOn, { metadata: true });
@@ -321,6 +322,29 @@ describe('project', () => {
             expect(cardTypeDetails.workflow).to.equal('simple-workflow');
         }
     });
+    it('access cached cardtype details (success)', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const project = new Project(decisionRecordsPath);
+        const cardtypeFile = join(project.cardtypesFolder, 'decision-cardtype.json');
+
+        const cardTypeDetails = await project.cardType('decision-cardtype');
+        expect(cardTypeDetails?.customFields?.at(0)?.displayName).to.not.equal(undefined);
+
+        // Returned details are copies; changing them does not change the cache.
+        if (cardTypeDetails) {
+            cardTypeDetails.workflow = 'changed-workflow';
+        }
+        expect((await project.cardType('decision-cardtype.json'))?.workflow).to.equal('decision-workflow');
+
+        // Changed cardtype file is read again.
+        const originalContent = await readFile(cardtypeFile, { encoding: 'utf-8' });
+        try {
+            await writeFile(cardtypeFile, originalContent.replace('decision-workflow', 'another-workflow'));
+            expect((await project.cardType('decision-cardtype.json'))?.workflow).to.equal('another-workflow');
+        } finally {
+            await writeFile(cardtypeFile, originalContent);
+        }
+    });
     it('try to access cardtype details with non-existing name', async () => {
         const decisionRecordsPath = join(testDir, 'valid/decision-records');
         const project = new Project(decisionRecordsPath);
@@ -349,6 +373,49 @@ describe('project', () => {
             }
         }
     });
+    it('read card tree underneath a card', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const project = new Project(decisionRecordsPath);
+
+        const cardTree = await project.cardTree({ metadata: true, attachments: true }, 'decision_5');
+        expect(cardTree.length).to.equal(1);
+        const rootCard = cardTree.at(0);
+        expect(rootCard?.key).to.equal('decision_5');
+        expect(rootCard?.attachments?.length).to.equal(1);
+        expect(rootCard?.children?.length).to.equal(1);
+        expect(rootCard?.children?.at(0)?.key).to.equal('decision_6');
+        expect(rootCard?.children?.at(0)?.metadata).to.not.equal(undefined);
+        expect(rootCard?.children?.at(0)?.attachments?.length).to.equal(0);
+
+        const missing = await project.cardTree({}, 'decision_999');
+        expect(missing.length).to.equal(0);
+    });
+    it('iterate project cards', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const project = new Project(decisionRecordsPath);
+
+        const keys: string[] = [];
+        for await (const card of project.iterateCards({ metadata: true })) {
+            expect(card.metadata).to.not.equal(undefined);
+            expect(card.children).to.equal(undefined);
+            keys.push(card.key);
+        }
+        expect(keys.length).to.equal(2);
+        expect(keys).to.include('decision_5');
+        expect(keys).to.include('decision_6');
+
+        const subtreeKeys: string[] = [];
+        for await (const card of project.iterateCards({}, 'decision_6')) {
+            subtreeKeys.push(card.key);
+        }
+        expect(subtreeKeys.length).to.equal(1);
+
+        const templateKeys: string[] = [];
+        for await (const card of project.iterateCards({}, 'decision_1')) {
+            templateKeys.push(card.key);
+        }
+        expect(templateKeys.length).to.equal(1);
+    });
     it('empty project does not have cards', async () => {
         const emptyProjectPath = join(testDir, 'valid/minimal');
         const project = new Project(emptyProjectPath);
@@ -401,6 +468,15 @@ describe('project', () => {
         const template = await project.createTemplateObjectByName('decision');
         expect(template).to.not.equal(undefined);
     });
+    it('template objects are created once per project', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const project = new Project(decisionRecordsPath);
+        const template = await project.createTemplateObjectByName('decision');
+        expect(await project.createTemplateObjectByName('local/decision')).to.equal(template);
+        expect(await project.createTemplateObject({ name: 'decision' })).to.equal(template);
+        expect(await project.createTemplateObjectByName('idontexist')).to.equal(undefined);
+        expect(await new Project(decisionRecordsPath).createTemplateObjectByName('decision')).to.not.equal(template);
+    });
     it('find certain card from project - content as adoc (success)', async () => {
         const decisionRecordsPath = join(testDir, 'valid/decision-records');
         const project = new Project(decisionRecordsPath);
@@ -423,6 +499,17 @@ describe('project', () => {
         const existingCard = await project.findSpecificCard('decision_5', { content: true, contentType: 'html' });
         expect(existingCard).to.not.equal(undefined);
     });
+    it('find template cards from project (success)', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const project = new Project(decisionRecordsPath);
+        const templatesFolder = project.templatesFolder;
+
+        const templateCard = await project.findSpecificCard('decision_3', { content: true });
+        expect(templateCard?.path).to.equal(join(templatesFolder, 'simplepage', 'c', 'decision_3'));
+        expect(templateCard?.content).to.not.equal(undefined);
+        expect(await project.cardFolder('decision_1')).to.equal(join(templatesFolder, 'decision', 'c', 'decision_1'));
+        expect(await project.cardFolder('mini_999')).to.equal('');
+    });
     it('check if project is created (success)', async () => {
         const decisionRecordsPath = join(testDir, 'valid/decision-records');
         const project = new Project(decisionRecordsPath);
@@ -168,7 +168,7 @@ describe('template', () => {
     it('access card details by id', async () => {
         const template = new Template(path, { name: 'decision' });
         const cardToOperateOn = 'decision_1';
-        const cardExists = template.hasCard(cardToOperateOn);
+        const cardExists = await template.hasCard(cardToOperateOn);
         expect(cardExists).to.equal(true);
 
         const card = await template.cardDetailsById(cardToOperateOn, { metadata: true });
@@ -0,0 +1,94 @@
+// testing
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+// node
+import { join } from 'node:path';
+
+// ismo
+import { CalculationQueue } from '../../src/utils/calculation-queue.js';
+
+// Job that finishes after 'ms' milliseconds, or when it is aborted.
+function delay<T>(ms: number, value: T) {
+    return (signal: AbortSignal) => new Promise<T>((resolve, reject) => {
+        const timer = setTimeout(() => resolve(value), ms);
+        signal.addEventListener('abort', () => {
+            clearTimeout(timer);
+            reject(signal.reason);
+        });
+    });
+}
+
+describe('calculation queue', () => {
+    const root = join('/tmp', 'project', 'cardroot');
+
+    it('runs jobs and reports their status', async () => {
+        const queue = new CalculationQueue();
+        const first = queue.enqueue('run', join(root, 'decision_5'), delay(10, 'first'), { cardKey: 'decision_5' });
+        const second = queue.enqueue('run', join(root, 'decision_6'), delay(10, 'second'));
+        expect(first.job.cardKey).to.equal('decision_5');
+        expect(queue.job(first.job.id)?.state).to.equal('running');
+
+        expect(await first.result).to.equal('first');
+        expect(await second.result).to.equal('second');
+        expect(queue.jobs().map(job => job.state)).to.deep.equal(['done', 'done']);
+        expect(queue.job(999)).to.equal(undefined);
+    });
+    it('exclusive job runs alone', async () => {
+        const queue = new CalculationQueue();
+        const order: string[] = [];
+        const job = (name: string) => async (signal: AbortSignal) => {
+            order.push(`${name} start`);
+            await delay(10, name)(signal);
+            order.push(`${name} end`);
+        };
+        queue.enqueue('run', root, job('a'));
+        queue.enqueue('generate', root, job('b'), { exclusive: true });
+        queue.enqueue('run', root, job('c'));
+        await queue.idle();
+        expect(order).to.deep.equal(['a start', 'a end', 'b start', 'b end', 'c start', 'c end']);
+    });
+    it('newer job supersedes earlier jobs of the same subtree', async () => {
+        const queue = new CalculationQueue();
+        const subtree = queue.enqueue('generate', join(root, 'decision_5'), delay(50, 'subtree'), { exclusive: true, supersede: true });
+        const other = queue.enqueue('run', join(root, 'decision_5'), delay(10, 'other'));
+        const tree = queue.enqueue('generate', root, delay(10, 'tree'), { exclusive: true, supersede: true });
+
+        try {
+            await subtree.result;
+            expect(false).to.equal(true);
+        } catch (error) {
+            expect((error as Error).message).to.equal(`Calculation job ${subtree.job.id} was cancelled`);
+        }
+        expect(await other.result).to.equal('other');
+        expect(await tree.result).to.equal('tree');
+        expect(queue.job(subtree.job.id)?.state).to.equal('cancelled');
+    });
+    it('job times out', async () => {
+        const queue = new CalculationQueue();
+        const slow = queue.enqueue('run', root, delay(1000, 'slow'), { timeout: 10 });
+        try {
+            await slow.result;
+            expect(false).to.equal(true);
+        } catch (error) {
+            expect((error as Error).message).to.include('timed out');
+        }
+        expect(queue.job(slow.job.id)?.state).to.equal('timeout');
+        expect(queue.cancel(slow.job.id)).to.equal(false);
+    });
+    it('delayed job waits before it starts; later jobs do not wait for it', async () => {
+        const queue = new CalculationQueue();
+        const delayed = queue.enqueue('update', root, delay(0, 'delayed'), { delay: 20, exclusive: true });
+        const next = queue.enqueue('run', root, delay(0, 'next'));
+        expect(queue.job(delayed.job.id)?.state).to.equal('queued');
+        expect(queue.postpone(delayed.job.id, 30)).to.equal(true);
+
+        expect(await next.result).to.equal('next');
+        expect(queue.job(delayed.job.id)?.state).to.equal('queued');
+        expect(await delayed.result).to.equal('delayed');
+        const status = queue.job(delayed.job.id);
+        expect(status?.state).to.equal('done');
+        expect(status!.started! - status!.queued).to.be.greaterThan(25);
+        expect(queue.postpone(delayed.job.id, 30)).to.equal(false);
+    });
+});
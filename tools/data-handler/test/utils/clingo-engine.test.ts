@@ -0,0 +1,238 @@
+// testing
+import { expect } from 'chai';
+import { after, before, describe, it } from 'mocha';
+
+// node
+import { spawnSync } from 'node:child_process';
+import { chmodSync, existsSync, mkdirSync, readFileSync, rmSync, writeFileSync } from 'node:fs';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+// ismo
+import { ClingoEngine } from '../../src/utils/clingo-engine.js';
+
+// Create test artifacts in a temp directory.
+const baseDir = dirname(fileURLToPath(import.meta.url));
+const testDir = join(baseDir, 'tmp-clingo-engine-tests');
+
+// Fake clingo (CommonJS script). As a worker it answers each query with its process id, so that
+// tests can check which process answered. Query of card 'slow' is answered only when it is cancelled.
+// Without worker support it exits when started as a worker.
+// Grounding writes the name of the grounded file; a query tells if it was run with the grounded program.
+function fakeClingo(name: string, workerSupport: boolean): string {
+    const file = join(testDir, name);
+    writeFileSync(file, `#!/usr/bin/env node
+const readline = require('node:readline');
+const worker = process.argv.some(arg => arg.endsWith('${ClingoEngine.workerFileName}'));
+if (worker && !${workerSupport}) {
+    console.error('error: python support not available');
+    process.exit(65);
+}
+if (process.argv.includes('--text')) {
+    console.log('grounded(' + JSON.stringify(process.argv.at(-1)) + ').');
+    process.exit(0);
+}
+if (worker) {
+    console.log(JSON.stringify({ ready: true }));
+    readline.createInterface({ input: process.stdin }).on('line', line => {
+        const request = JSON.parse(line);
+        if (request.cancel !== undefined) {
+            console.log(JSON.stringify({ id: request.cancel, error: 'query was cancelled' }));
+            return;
+        }
+        const key = request.program.match(/Cardkey = (\\w+)/)[1];
+        const guarded = request.program.includes('#external query(' + request.id + ').');
+        if (key === 'slow') {
+            return;
+        }
+        console.log(JSON.stringify({ id: request.id, satisfiable: guarded, symbols: ['field(' + key + ',"pid",' + process.pid + ')'] }));
+    });
+} else {
+    let input = '';
+    process.stdin.on('data', data => input += data);
+    process.stdin.on('end', () => {
+        const key = input.match(/Cardkey = (\\w+)/)[1];
+        const grounded = process.argv.at(-1).endsWith('${ClingoEngine.groundFileName}');
+        console.log('field(' + key + ',"pid",' + (grounded ? 'grounded' : 'once') + ')');
+        console.log('SATISFIABLE');
+    });
+}
+`);
+    chmodSync(file, 0o755);
+    return file;
+}
+
+// Checks if clingo is installed.
+function clingoAvailable(binaryName: string): boolean {
+    return spawnSync(binaryName, ['--version']).status === 0;
+}
+
+// Query used in the tests.
+function query(cardKey: string) {
+    return (guard: string) => `#show field(Cardkey, Field, Value): field(Cardkey, Field, Value), Cardkey = ${cardKey}, ${guard}.`;
+}
+
+describe('clingo engine', () => {
+    const binaryName = ClingoEngine.binaryName;
+    const persistent = ClingoEngine.persistent;
+
+    before(() => {
+        mkdirSync(testDir, { recursive: true });
+        ClingoEngine.persistent = true;
+    });
+
+    after(() => {
+        ClingoEngine.binaryName = binaryName;
+        ClingoEngine.persistent = persistent;
+        rmSync(testDir, { recursive: true, force: true });
+    });
+
+    it('keeps base program loaded in a worker', async () => {
+        ClingoEngine.binaryName = fakeClingo('clingo-worker.cjs', true);
+        const calcFolder = join(testDir, 'worker');
+        mkdirSync(calcFolder);
+        const mainFile = join(calcFolder, 'main.lp');
+        writeFileSync(mainFile, '#include "base.lp".\n');
+        writeFileSync(join(calcFolder, 'base.lp'), 'a.\n');
+        const engine = ClingoEngine.getInstance(mainFile);
+        expect(ClingoEngine.getInstance(mainFile)).to.equal(engine);
+
+        const first = await engine.solve(query('decision_5'));
+        const [firstAnswer, status] = first.split('\n');
+        expect(firstAnswer).to.match(/^field\(decision_5,"pid",\d+\)$/);
+        expect(status).to.equal('SATISFIABLE');
+        const answers = await Promise.all([engine.solve(query('decision_6')), engine.solve(query('decision_5'))]);
+        expect(answers[1]).to.equal(first);
+        expect(answers[0]).to.equal(first.replace('decision_5', 'decision_6'));
+
+        // Changed base program is loaded by a new worker.
+        writeFileSync(join(calcFolder, 'base.lp'), 'a.\nb.\n');
+        engine.invalidate();
+        expect(await engine.solve(query('decision_5'))).to.not.equal(first);
+        engine.close();
+    });
+    it('aborted query is interrupted without restarting the worker', async () => {
+        ClingoEngine.binaryName = fakeClingo('clingo-worker-abort.cjs', true);
+        const calcFolder = join(testDir, 'worker-abort');
+        mkdirSync(calcFolder);
+        const mainFile = join(calcFolder, 'main.lp');
+        writeFileSync(mainFile, 'a.\n');
+        const engine = ClingoEngine.getInstance(mainFile);
+        const first = await engine.solve(query('decision_5'));
+
+        const controller = new AbortController();
+        const slow = engine.solve(query('slow'), controller.signal);
+        controller.abort();
+        try {
+            await slow;
+            expect(false).to.equal(true);
+        } catch (error) {
+            expect((error as Error).message).to.equal('Clingo error: query was aborted');
+        }
+        expect(await engine.solve(query('decision_5'))).to.equal(first);
+        engine.close();
+    });
+    it('does not start workers in short-lived processes', async () => {
+        ClingoEngine.binaryName = fakeClingo('clingo-worker-once.cjs', true);
+        const calcFolder = join(testDir, 'worker-once');
+        mkdirSync(calcFolder);
+        const mainFile = join(calcFolder, 'main.lp');
+        writeFileSync(mainFile, 'a.\n');
+        ClingoEngine.persistent = false;
+        try {
+            expect(await ClingoEngine.getInstance(mainFile).solve(query('decision_5'))).to.equal('field(decision_5,"pid",once)\nSATISFIABLE\n');
+        } finally {
+            ClingoEngine.persistent = true;
+        }
+    });
+    it('runs a new process when worker is not available', async () => {
+        ClingoEngine.binaryName = fakeClingo('clingo-no-worker.cjs', false);
+        const calcFolder = join(testDir, 'no-worker');
+        mkdirSync(calcFolder);
+        const mainFile = join(calcFolder, 'main.lp');
+        writeFileSync(mainFile, '');
+        const engine = ClingoEngine.getInstance(mainFile);
+        expect(await engine.solve(query('decision_5'))).to.equal('field(decision_5,"pid",once)\nSATISFIABLE\n');
+        expect(await engine.solve(query('decision_6'))).to.equal('field(decision_6,"pid",once)\nSATISFIABLE\n');
+
+        // Output can be received in pieces instead.
+        const chunks: string[] = [];
+        expect(await engine.solve(query('decision_5'), undefined, chunk => chunks.push(chunk))).to.equal('');
+        expect(chunks.join('')).to.equal('field(decision_5,"pid",once)\nSATISFIABLE\n');
+    });
+    it('uses grounded program until program files change', async () => {
+        ClingoEngine.binaryName = fakeClingo('clingo-ground.cjs', false);
+        const calcFolder = join(testDir, 'ground');
+        mkdirSync(calcFolder);
+        const mainFile = join(calcFolder, 'main.lp');
+        writeFileSync(mainFile, '#include "base.lp".\n');
+        writeFileSync(join(calcFolder, 'base.lp'), 'a.\n');
+        const engine = ClingoEngine.getInstance(mainFile);
+        expect(await engine.grounded()).to.equal(false);
+
+        await engine.ground();
+        expect(await engine.grounded()).to.equal(true);
+        const groundFile = join(calcFolder, ClingoEngine.groundFileName);
+        expect(readFileSync(groundFile, 'utf-8')).to.include(`grounded(${JSON.stringify(mainFile)}).`);
+        expect(await engine.solve(query('decision_5'))).to.equal('field(decision_5,"pid",grounded)\nSATISFIABLE\n');
+
+        // Changed program files are grounded again when queried.
+        writeFileSync(join(calcFolder, 'base.lp'), 'a.\nb.\n');
+        expect(await engine.grounded()).to.equal(false);
+        expect(await engine.solve(query('decision_5'))).to.equal('field(decision_5,"pid",once)\nSATISFIABLE\n');
+    });
+    it('grounded program gives the same answers as the program (with clingo)', async function () {
+        ClingoEngine.binaryName = binaryName;
+        if (!clingoAvailable(binaryName)) {
+            this.skip();
+        }
+        const calcFolder = join(testDir, 'ground-clingo');
+        mkdirSync(calcFolder);
+        const mainFile = join(calcFolder, 'main.lp');
+        writeFileSync(mainFile, '#include "base.lp".\n');
+        writeFileSync(join(calcFolder, 'base.lp'), `
+card(decision_5;decision_6;decision_7).
+parent(decision_6, decision_5). parent(decision_7, decision_6).
+ancestor(A, C) :- parent(A, C).
+ancestor(A, C) :- parent(A, B), ancestor(B, C).
+field(C, "ancestors", N) :- card(C), N = #count { A : ancestor(C, A) }.
+`);
+        const allCards = (guard: string) => `#show field(Cardkey, Field, Value): field(Cardkey, Field, Value), ${guard}.`;
+        const lines = (output: string) => output.split('\n').filter(line => line).sort();
+        const engine = ClingoEngine.getInstance(mainFile);
+        const expected = lines(await engine.solve(allCards));
+        expect(expected).to.include('field(decision_7,"ancestors",2)');
+
+        await engine.ground();
+        expect(await engine.grounded()).to.equal(true);
+        expect(lines(await engine.solve(allCards))).to.deep.equal(expected);
+        expect(lines(await engine.solve(query('decision_6')))).to.deep.equal(['SATISFIABLE', 'field(decision_6,"ancestors",1)']);
+    });
+    it('grounding fails when clingo is missing', async () => {
+        ClingoEngine.binaryName = join(testDir, 'idontexist');
+        const calcFolder = join(testDir, 'ground-missing');
+        mkdirSync(calcFolder);
+        const mainFile = join(calcFolder, 'main.lp');
+        writeFileSync(mainFile, '');
+        try {
+            await ClingoEngine.getInstance(mainFile).ground();
+            expect(false).to.equal(true);
+        } catch (error) {
+            expect((error as Error).message).to.include('Cannot find "Clingo"');
+        }
+        expect(existsSync(join(calcFolder, ClingoEngine.groundFileName))).to.equal(false);
+    });
+    it('clingo is missing', async () => {
+        ClingoEngine.binaryName = join(testDir, 'idontexist');
+        const calcFolder = join(testDir, 'missing');
+        mkdirSync(calcFolder);
+        const mainFile = join(calcFolder, 'main.lp');
+        writeFileSync(mainFile, '');
+        try {
+            await ClingoEngine.getInstance(mainFile).solve(query('decision_5'));
+            expect(false).to.equal(true);
+        } catch (error) {
+            expect((error as Error).message).to.include('Cannot find "Clingo"');
+        }
+    });
+});
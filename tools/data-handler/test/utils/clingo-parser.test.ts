@@ -0,0 +1,55 @@
+// testing
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+// ismo
+import { clingoFunction, ClingoOutputParser } from '../../src/utils/clingo-parser.js';
+
+// Parses output given in chunks of 'size' characters.
+function parse(output: string, size: number) {
+    const symbols: clingoFunction[] = [];
+    const parser = new ClingoOutputParser(symbol => symbols.push(symbol));
+    for (let index = 0; index < output.length; index += size) {
+        parser.write(output.substring(index, index + size));
+    }
+    return { symbols: symbols, status: parser.end() };
+}
+
+describe('clingo output parser', () => {
+    const output = [
+        'field(decision_5,"summary","Say \\"hello\\", then \\\\ and\\nnew line")',
+        'field(decision_5,"count",-42)',
+        'field(decision_5,"owner",person(alice,(1,"a")))',
+        'label(decision_6,"ä€")',
+        'SATISFIABLE',
+    ].join('\n');
+
+    it('parses atoms with typed values', () => {
+        const { symbols, status } = parse(output, output.length);
+        expect(status).to.equal('SATISFIABLE');
+        expect(symbols.length).to.equal(4);
+        expect(symbols[0]).to.deep.equal({
+            name: 'field',
+            args: [{ name: 'decision_5', args: [] }, 'summary', 'Say "hello", then \\ and\nnew line'],
+        });
+        expect(symbols[1].args[2]).to.equal(-42);
+        expect(ClingoOutputParser.text(symbols[2].args[2])).to.equal('person(alice,(1,"a"))');
+        expect(symbols[3].args[1]).to.equal('ä€');
+    });
+    it('gives the same result regardless of how output is split', () => {
+        const whole = parse(output, output.length);
+        for (const size of [1, 2, 3, 7]) {
+            expect(parse(output, size)).to.deep.equal(whole);
+        }
+    });
+    it('parses atoms that are separated by spaces', () => {
+        const { symbols, status } = parse('a(1) b("x y") c\nUNSATISFIABLE\n', 4);
+        expect(symbols.map(symbol => symbol.name)).to.deep.equal(['a', 'b', 'c']);
+        expect(symbols[1].args).to.deep.equal(['x y']);
+        expect(status).to.equal('UNSATISFIABLE');
+    });
+    it('reports missing status', () => {
+        expect(parse('a(1)', 1).status).to.equal('');
+        expect(parse('OPTIMUM FOUND', 3).status).to.equal('OPTIMUM FOUND');
+    });
+});
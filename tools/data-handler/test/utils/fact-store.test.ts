@@ -0,0 +1,213 @@
+// testing
+import { expect } from 'chai';
+import { after, before, describe, it } from 'mocha';
+
+// node
+import { mkdirSync, readFileSync, readdirSync, rmSync } from 'node:fs';
+import { writeFile } from 'node:fs/promises';
+import { dirname, join } from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+// ismo
+import { Calculate } from '../../src/calculate.js';
+import { calculationJob, CalculationQueue } from '../../src/utils/calculation-queue.js';
+import { copyDir } from '../../src/utils/file-utils.js';
+import { FactStore } from '../../src/utils/fact-store.js';
+import { Project } from '../../src/containers/project.js';
+import { Remove } from '../../src/remove.js';
+import { Validate } from '../../src/validate.js';
+
+// Create test artifacts in a temp directory.
+const baseDir = dirname(fileURLToPath(import.meta.url));
+const testDir = join(baseDir, 'tmp-fact-store-tests');
+
+// Reads all facts from the store folder.
+function allFacts(calculationFolder: string): string {
+    const folder = join(calculationFolder, FactStore.folderName);
+    return readdirSync(folder).sort().map(file => readFileSync(join(folder, file), 'utf-8')).join('');
+}
+
+describe('fact store', () => {
+    const calculationFolder = join(testDir, 'calc');
+
+    before(async () => {
+        mkdirSync(testDir);
+        await copyDir('test/test-data/', testDir);
+    });
+
+    after(() => {
+        rmSync(testDir, { recursive: true, force: true });
+    });
+
+    it('writes, updates and removes card facts', async () => {
+        const store = new FactStore(calculationFolder);
+        const facts = new Map([
+            ['decision_1', 'field(decision_1, "summary", "one").'],
+            ['decision_2', 'field(decision_2, "summary", "two").\nparent(decision_2, decision_1).'],
+        ]);
+        await store.replaceAll(facts);
+        expect(readdirSync(join(calculationFolder, FactStore.folderName)).length).to.equal(FactStore.shardCount);
+        expect(store.files().length).to.equal(FactStore.shardCount);
+        expect(allFacts(calculationFolder)).to.include('parent(decision_2, decision_1).');
+
+        await store.update(new Map([['decision_1', 'field(decision_1, "summary", "changed").']]));
+        const updated = allFacts(calculationFolder);
+        expect(updated).to.include('"changed"');
+        expect(updated).to.not.include('"one"');
+        expect(updated).to.include('"two"');
+
+        await store.remove(['decision_2']);
+        const removed = allFacts(calculationFolder);
+        expect(removed).to.not.include('decision_2');
+        expect(removed).to.include('"changed"');
+    });
+    it('replaces all facts from a stream, or keeps current facts if the stream fails', async () => {
+        const store = new FactStore(calculationFolder);
+        await store.replaceAllFrom((async function* (): AsyncGenerator<[string, string]> {
+            for (let index = 0; index < 2000; index++) {
+                yield [`decision_${index}`, `field(decision_${index}, "summary", "${'x'.repeat(100)}").`];
+            }
+        })());
+        const facts = await store.facts(['decision_0', 'decision_1999']);
+        expect(facts.size).to.equal(2);
+        expect(readdirSync(join(calculationFolder, FactStore.folderName)).length).to.equal(FactStore.shardCount);
+
+        try {
+            await store.replaceAllFrom((async function* (): AsyncGenerator<[string, string]> {
+                yield ['decision_0', 'field(decision_0, "summary", "new").'];
+                throw new Error('cancelled');
+            })());
+            expect(false).to.equal(true);
+        } catch (error) {
+            expect((error as Error).message).to.equal('cancelled');
+        }
+        expect((await store.facts(['decision_1999'])).size).to.equal(1);
+        expect(readdirSync(join(calculationFolder, FactStore.folderName)).length).to.equal(FactStore.shardCount);
+    });
+    it('generate writes card facts to the store', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        await new Calculate().generate(decisionRecordsPath);
+
+        const projectCalculationFolder = new Project(decisionRecordsPath).calculationFolder;
+        const cardTree = readFileSync(join(projectCalculationFolder, 'cardtree.lp'), 'utf-8');
+        expect(cardTree.split('\n').filter(line => line).length).to.equal(FactStore.shardCount);
+        const facts = allFacts(projectCalculationFolder);
+        expect(facts).to.include('field(decision_5, "cardtype", "simplepage-cardtype").');
+        expect(facts).to.include('parent(decision_6, decision_5).');
+        expect(facts).to.include('ancestor(decision_6, decision_5).');
+        expect(facts).to.include('depth(decision_5, 0).');
+        expect(facts).to.include('depth(decision_6, 1).');
+        expect(facts).to.include('childCount(decision_5, 1).');
+        expect(facts).to.include('childCount(decision_6, 0).');
+        const base = readFileSync(join(projectCalculationFolder, 'base.lp'), 'utf-8');
+        expect(base).to.not.include('ancestor(');
+    });
+    it('project with generated logic program is valid', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const result = await Validate.getInstance().validate(decisionRecordsPath);
+        expect(result).to.equal('');
+    });
+    it('generate without tree facts lets clingo derive ancestors', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        Calculate.treeFacts = false;
+        try {
+            await new Calculate().generate(decisionRecordsPath);
+        } finally {
+            Calculate.treeFacts = true;
+        }
+        const projectCalculationFolder = new Project(decisionRecordsPath).calculationFolder;
+        const facts = allFacts(projectCalculationFolder);
+        expect(facts).to.include('parent(decision_6, decision_5).');
+        expect(facts).to.not.include('ancestor(');
+        expect(facts).to.not.include('depth(');
+        const base = readFileSync(join(projectCalculationFolder, 'base.lp'), 'utf-8');
+        expect(base).to.include('ancestor(A, C) :- parent(A, B), ancestor(B, C).');
+
+        await new Calculate().generate(decisionRecordsPath);
+    });
+    it('new and removed cards update the number of children of their parent', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const project = new Project(decisionRecordsPath);
+        const calculate = new Calculate();
+        const parent = await project.findSpecificCard('decision_6');
+        const newCard = join(parent!.path, 'c', 'decision_8');
+        mkdirSync(newCard, { recursive: true });
+        await writeFile(join(newCard, Project.cardMetadataFile), JSON.stringify({ cardtype: 'simplepage-cardtype', summary: 'Child', workflowState: 'Created' }));
+
+        await calculate.handleNewCards([(await project.findSpecificCard('decision_8'))!]);
+        await CalculationQueue.getInstance(decisionRecordsPath).idle();
+        let facts = allFacts(project.calculationFolder);
+        expect(facts).to.include('childCount(decision_6, 1).');
+        expect(facts).to.include('ancestor(decision_8, decision_5).');
+        expect(facts).to.include('depth(decision_8, 2).');
+
+        await new Remove(calculate).remove(decisionRecordsPath, 'card', 'decision_8');
+        await CalculationQueue.getInstance(decisionRecordsPath).idle();
+        facts = allFacts(project.calculationFolder);
+        expect(facts).to.include('childCount(decision_6, 0).');
+        expect(facts).to.not.include('decision_8');
+    });
+    it('card changes update only facts of the changed cards', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const project = new Project(decisionRecordsPath);
+        const card = await project.findSpecificCard('decision_6', { metadata: true });
+        expect(card).to.not.equal(undefined);
+        if (!card?.metadata) {
+            return;
+        }
+        // Facts of other cards are kept as they are, even if cards have changed.
+        const otherCard = await project.findSpecificCard('decision_5', { metadata: true });
+        await writeFile(join(otherCard!.path, Project.cardMetadataFile), JSON.stringify({ ...otherCard!.metadata, summary: 'Not updated' }));
+        await writeFile(join(card.path, Project.cardMetadataFile), JSON.stringify({ ...card.metadata, workflowState: 'Approved' }));
+
+        const calculate = new Calculate();
+        const status = await calculate.handleCardChanged(card);
+        expect((status.payload as calculationJob).name).to.equal('update');
+        await CalculationQueue.getInstance(decisionRecordsPath).idle();
+
+        const facts = allFacts(project.calculationFolder);
+        expect(facts).to.include('field(decision_6, "workflowState", "Approved").');
+        expect(facts).to.include('parent(decision_6, decision_5).');
+        expect(facts).to.include('field(decision_5, "summary", "Decision Records").');
+        expect(calculate.jobs(decisionRecordsPath).at(-1)?.state).to.equal('done');
+    });
+    it('card facts are written according to field types', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const project = new Project(decisionRecordsPath);
+        const card = await project.findSpecificCard('decision_6', { metadata: true });
+        await writeFile(join(card!.path, Project.cardMetadataFile), JSON.stringify({
+            ...card!.metadata,
+            obsoletedBy: 'Say "hi"\nto C:\\temp',
+            admins: ['alice', 'bob'],
+            finished: false,
+            'number-of-commits': 42,
+            'percentage-ready': 12.5,
+            labels: ['a "label"'],
+        }));
+
+        await new Calculate().handleCardChanged(card!);
+        await CalculationQueue.getInstance(decisionRecordsPath).idle();
+
+        const facts = allFacts(project.calculationFolder);
+        expect(facts).to.include('field(decision_6, "obsoletedBy", "Say \\"hi\\"\\nto C:\\\\temp").');
+        expect(facts).to.include('field(decision_6, "admins", "alice").\nfield(decision_6, "admins", "bob").');
+        expect(facts).to.include('field(decision_6, "finished", false).');
+        expect(facts).to.include('field(decision_6, "number-of-commits", 42).');
+        expect(facts).to.include('field(decision_6, "percentage-ready", "12.5").');
+        expect(facts).to.include('label(decision_6, "a \\"label\\"").');
+        expect(facts).to.include('field(decision_6, "responsible", "null").');
+    });
+    it('deleting a card removes facts of the card and its descendants', async () => {
+        const decisionRecordsPath = join(testDir, 'valid/decision-records');
+        const project = new Project(decisionRecordsPath);
+        const card = await project.findSpecificCard('decision_5');
+        expect(card).to.not.equal(undefined);
+
+        await new Calculate().handleDeleteCard(card!);
+        await CalculationQueue.getInstance(decisionRecordsPath).idle();
+
+        const facts = allFacts(project.calculationFolder);
+        expect(facts).to.not.include('decision_5');
+        expect(facts).to.not.include('decision_6');
+    });
+});
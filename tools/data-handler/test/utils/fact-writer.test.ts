@@ -0,0 +1,36 @@
+// testing
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+// ismo
+import { ClingoOutputParser } from '../../src/utils/clingo-parser.js';
+import { FactWriter } from '../../src/utils/fact-writer.js';
+
+describe('fact writer', () => {
+    it('writes integers and booleans natively', () => {
+        expect(FactWriter.fieldFacts('decision_5', 'count', 7, 'integer')).to.deep.equal(['field(decision_5, "count", 7).']);
+        expect(FactWriter.fieldFacts('decision_5', 'count', '-7', 'integer')).to.deep.equal(['field(decision_5, "count", -7).']);
+        expect(FactWriter.fieldFacts('decision_5', 'ready', true, 'boolean')).to.deep.equal(['field(decision_5, "ready", true).']);
+        expect(FactWriter.fieldFacts('decision_5', 'ready', 'false', 'boolean')).to.deep.equal(['field(decision_5, "ready", false).']);
+    });
+    it('writes numbers that are not clingo integers as strings', () => {
+        expect(FactWriter.fieldFacts('decision_5', 'ratio', 0.5, 'number')).to.deep.equal(['field(decision_5, "ratio", "0.5").']);
+        expect(FactWriter.fieldFacts('decision_5', 'count', 2 ** 31, 'integer')).to.deep.equal([`field(decision_5, "count", "${2 ** 31}").`]);
+        expect(FactWriter.fieldFacts('decision_5', 'count', '', 'integer')).to.deep.equal(['field(decision_5, "count", "").']);
+    });
+    it('writes one fact per list element, and "null" for missing values', () => {
+        expect(FactWriter.fieldFacts('decision_5', 'admins', ['a', 1, null], 'list')).to.deep.equal([
+            'field(decision_5, "admins", "a").',
+            'field(decision_5, "admins", 1).',
+            'field(decision_5, "admins", "null").',
+        ]);
+        expect(FactWriter.fieldFacts('decision_5', 'admins', [], 'list')).to.deep.equal([]);
+        expect(FactWriter.fieldFacts('decision_5', 'owner', null, 'person')).to.deep.equal(['field(decision_5, "owner", "null").']);
+        expect(FactWriter.fieldFacts('decision_5', 'count', undefined, 'integer')).to.deep.equal(['field(decision_5, "count", "null").']);
+    });
+    it('escapes strings so that clingo reads them back unchanged', () => {
+        const text = 'Say "hi"\nto C:\\temp';
+        expect(FactWriter.string(text)).to.equal(ClingoOutputParser.text(text));
+        expect(FactWriter.labelFacts('decision_5', ['"quoted"'])).to.deep.equal(['label(decision_5, "\\"quoted\\"").']);
+    });
+});
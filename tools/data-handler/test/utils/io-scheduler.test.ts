@@ -0,0 +1,71 @@
+// testing
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+// ismo
+import { IOScheduler } from '../../src/utils/io-scheduler.js';
+
+// Operation that finishes when the returned 'finish' is called.
+function pendingOperation() {
+    let finish: () => void = () => {};
+    const done = new Promise<void>(resolve => { finish = resolve; });
+    return { operation: () => done, finish: () => finish() };
+}
+
+describe('I/O scheduler', () => {
+    it('limits number of concurrent operations', async () => {
+        const scheduler = new IOScheduler(2);
+        const operations = [pendingOperation(), pendingOperation(), pendingOperation()];
+        const results = operations.map(item => scheduler.schedule(item.operation));
+
+        let statistics = scheduler.statistics();
+        expect(statistics.inFlight).to.equal(2);
+        expect(statistics.queued).to.equal(1);
+
+        operations.forEach(item => item.finish());
+        await Promise.all(results);
+        statistics = scheduler.statistics();
+        expect(statistics.inFlight).to.equal(0);
+        expect(statistics.queued).to.equal(0);
+        expect(statistics.completed).to.equal(3);
+    });
+    it('starts interactive operations before background operations', async () => {
+        const scheduler = new IOScheduler(1);
+        const blocking = pendingOperation();
+        const order: string[] = [];
+        const results = [
+            scheduler.schedule(blocking.operation),
+            scheduler.schedule(async () => { order.push('background'); }, 'background'),
+            scheduler.schedule(async () => { order.push('interactive'); }, 'interactive'),
+        ];
+        expect(scheduler.statistics().queuedInteractive).to.equal(1);
+        expect(scheduler.statistics().queuedBackground).to.equal(1);
+
+        blocking.finish();
+        await Promise.all(results);
+        expect(order.at(0)).to.equal('interactive');
+        expect(order.at(1)).to.equal('background');
+    });
+    it('reports failed operations', async () => {
+        const scheduler = new IOScheduler(1);
+        try {
+            await scheduler.schedule(async () => { throw new Error('failed operation'); });
+            expect(false).to.equal(true);
+        } catch (error) {
+            if (error instanceof Error) {
+                expect(error.message).to.equal('failed operation');
+            }
+        }
+        const statistics = scheduler.statistics();
+        expect(statistics.failed).to.equal(1);
+        expect(statistics.inFlight).to.equal(0);
+        expect(await scheduler.schedule(async () => 'next')).to.equal('next');
+    });
+    it('try to set invalid concurrency', () => {
+        const scheduler = new IOScheduler();
+        expect(() => scheduler.setConcurrency(0)).to.throw();
+        expect(scheduler.concurrency).to.equal(IOScheduler.defaultConcurrency);
+        scheduler.setConcurrency(8);
+        expect(scheduler.concurrency).to.equal(8);
+    });
+});